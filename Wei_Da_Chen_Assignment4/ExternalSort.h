@@ -0,0 +1,372 @@
+/**
+ * External-memory sorting of binary files of fixed-width records.
+ * Input is cut into memory-budgeted chunks that are sorted with the
+ * drivers in Sort.h and spilled to temporary run files, which are then
+ * k-way merged with double-buffered, sequential I/O.
+ */
+
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include "Sort.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+using namespace std;
+
+/**
+ * Smallest I/O block the merge uses per buffer. A merge whose buffers
+ * would come out smaller under the memory budget is split into several
+ * passes with a lower fan-in instead.
+ */
+const size_t kExternalSortMinBlockBytes = 1 << 16;
+
+/**
+ * Settings for ExternalSort.
+ * memory_budget_bytes caps the records held in memory at once: the
+ * chunk sorted in the run phase together with the scratch space of the
+ * in-memory sort, and all merge buffers together.
+ * temp_directory is where run files are created; they are removed
+ * when no longer needed.
+ * stable selects MergeSort for the chunks, and keeps equal records in
+ * input order through the merge; otherwise QuickSort is used.
+ */
+struct ExternalSortOptions {
+    size_t memory_budget_bytes = 64 << 20;
+    string temp_directory = ".";
+    bool stable = false;
+};
+
+/**
+ * What ExternalSort did and how long it took.
+ */
+struct ExternalSortStats {
+    size_t records = 0;
+    size_t bytes = 0;
+    int runs = 0;
+    int merge_passes = 0;
+    double run_seconds = 0;
+    double merge_seconds = 0;
+
+    // Input size over total time, in MB/s.
+    double throughput( ) const {
+        double seconds = run_seconds + merge_seconds;
+        return seconds > 0 ? bytes / seconds / 1e6 : 0.0;
+    }
+};
+
+/**
+ * Internal class for ExternalSort that reads a run file front to back
+ * in blocks of blockRecords records. The next block is read on another
+ * thread while the current one is consumed.
+ */
+template <typename Record>
+class ExternalRunReader {
+  public:
+    ExternalRunReader( FILE * file, size_t blockRecords )
+      : file( file ), current( blockRecords ), next( blockRecords ) {
+        startRead( );
+        advance( );
+    }
+
+    bool empty( ) const {
+        return position == count;
+    }
+
+    const Record & front( ) const {
+        return current[ position ];
+    }
+
+    void pop( ) {
+        if( ++position == count )
+            advance( );
+    }
+
+  private:
+    FILE * file;
+    vector<Record> current;
+    vector<Record> next;
+    size_t position = 0;
+    size_t count = 0;
+    future<size_t> pending;
+
+    void startRead( ) {
+        pending = async( launch::async, [this]( ) {
+            return fread( next.data( ), sizeof( Record ), next.size( ), file );
+        } );
+    }
+
+    void advance( ) {
+        count = pending.get( );
+        position = 0;
+        current.swap( next );
+        if( count > 0 )
+            startRead( );
+    }
+};
+
+/**
+ * Internal class for ExternalSort that appends records to a file in
+ * blocks of blockRecords records. A full block is written on another
+ * thread while the next one is filled.
+ */
+template <typename Record>
+class ExternalRunWriter {
+  public:
+    ExternalRunWriter( FILE * file, size_t blockRecords )
+      : file( file ), blockRecords( blockRecords ) {
+        current.reserve( blockRecords );
+        next.reserve( blockRecords );
+    }
+
+    void push( const Record & x ) {
+        current.push_back( x );
+        if( current.size( ) == blockRecords )
+            flush( );
+    }
+
+    // Writes out everything pushed so far. Returns false on a write error.
+    bool finish( ) {
+        flush( );
+        return wait( ) && !failed;
+    }
+
+  private:
+    FILE * file;
+    size_t blockRecords;
+    vector<Record> current;
+    vector<Record> next;
+    future<bool> pending;
+    bool failed = false;
+
+    bool wait( ) {
+        if( pending.valid( ) && !pending.get( ) )
+            failed = true;
+        return !failed;
+    }
+
+    void flush( ) {
+        wait( );
+        current.swap( next );
+        current.clear( );
+        if( next.empty( ) )
+            return;
+        pending = async( launch::async, [this]( ) {
+            return fwrite( next.data( ), sizeof( Record ), next.size( ), file ) == next.size( );
+        } );
+    }
+};
+
+/**
+ * Internal methods for ExternalSort.
+ * externalRunPrefix returns a prefix in directory for the run files of
+ * one call, unique across the calls of this process and, by its process
+ * ID, across processes sharing directory. externalRunPath returns the
+ * path of the call's index-th run file.
+ */
+inline string externalRunPrefix( const string & directory ) {
+    static atomic<unsigned long long> calls( 0 );
+#ifdef __unix__
+    const long long process = getpid( );
+#else
+    const long long process = chrono::steady_clock::now( ).time_since_epoch( ).count( );
+#endif
+    return directory + "/external_sort_" + to_string( process ) + "_" + to_string( calls++ ) + "_";
+}
+
+inline string externalRunPath( const string & prefix, int index ) {
+    return prefix + to_string( index ) + ".run";
+}
+
+/**
+ * Internal method for ExternalSort that k-way merges the run files
+ * at paths into the file at output_path with a heap keyed on each
+ * run's front record. Ties go to the run with the lower index, which
+ * keeps the merge stable since runs are numbered in input order.
+ * blockRecords is the size of each of the 2 * (k + 1) I/O buffers.
+ * Returns false on an I/O error.
+ */
+template <typename Record, typename Comparator>
+bool mergeRuns( const vector<string> & paths, const string & output_path, size_t blockRecords, Comparator less_than ) {
+    FILE * output = fopen( output_path.c_str( ), "wb" );
+    if( output == nullptr )
+        return false;
+
+    bool ok = true;
+    vector<FILE *> files;
+    for( const string & path : paths ) {
+        FILE * file = fopen( path.c_str( ), "rb" );
+        if( file == nullptr ) {
+            ok = false;
+            break;
+        }
+        files.push_back( file );
+    }
+
+    if( ok ) {
+        vector<unique_ptr<ExternalRunReader<Record>>> readers;
+        for( FILE * file : files )
+            readers.emplace_back( new ExternalRunReader<Record>( file, blockRecords ) );
+        ExternalRunWriter<Record> writer( output, blockRecords );
+
+        // Top of the heap holds the front record that comes first, and its run
+        typedef pair<Record, int> Entry;
+        auto after = [&]( const Entry & x, const Entry & y ) {
+            if( less_than( y.first, x.first ) )
+                return true;
+            return !less_than( x.first, y.first ) && y.second < x.second;
+        };
+        priority_queue<Entry, vector<Entry>, decltype( after )> heap( after );
+        for( int i = 0; i < static_cast<int>( readers.size( ) ); ++i )
+            if( !readers[ i ]->empty( ) )
+                heap.push( Entry( readers[ i ]->front( ), i ) );
+
+        while( !heap.empty( ) ) {
+            int i = heap.top( ).second;
+            writer.push( heap.top( ).first );
+            heap.pop( );
+            readers[ i ]->pop( );
+            if( !readers[ i ]->empty( ) )
+                heap.push( Entry( readers[ i ]->front( ), i ) );
+        }
+        ok = writer.finish( );
+    }
+
+    for( FILE * file : files ) {
+        if( ferror( file ) )
+            ok = false;
+        fclose( file );
+    }
+    return fclose( output ) == 0 && ok;
+}
+
+/**
+ * Internal method for ExternalSort: the run phase.
+ * Reads input in chunks of chunkRecords records, sorts each chunk in
+ * memory and writes it to a new run file named from runPrefix, whose
+ * path is added to paths.
+ * Returns false on an I/O error.
+ */
+template <typename Record, typename Comparator>
+bool createRuns( FILE * input, size_t chunkRecords, const ExternalSortOptions & options, const string & runPrefix,
+                 Comparator less_than, vector<string> & paths, ExternalSortStats & stats ) {
+    vector<Record> chunk( chunkRecords );
+    for( ; ; ) {
+        size_t count = fread( chunk.data( ), sizeof( Record ), chunkRecords, input );
+        if( count == 0 )
+            return !ferror( input );
+        chunk.resize( count );
+
+        if( options.stable )
+            MergeSort( chunk, less_than );
+        else
+            QuickSort( chunk, less_than );
+
+        string path = externalRunPath( runPrefix, paths.size( ) );
+        FILE * run = fopen( path.c_str( ), "wb" );
+        if( run == nullptr )
+            return false;
+        paths.push_back( path );
+        bool written = fwrite( chunk.data( ), sizeof( Record ), count, run ) == count;
+        if( fclose( run ) != 0 || !written )
+            return false;
+
+        stats.records += count;
+        ++stats.runs;
+        if( count < chunkRecords )
+            return !ferror( input );
+    }
+}
+
+/**
+ * Sorts the binary file at input_path, a plain array of Record, into
+ * output_path using at most options.memory_budget_bytes of record
+ * buffers. Record must be trivially copyable.
+ * Sorted runs of half a budget's worth of records are created first. They
+ * are then merged as many at a time as the budget allows with buffers
+ * of at least kExternalSortMinBlockBytes, in as many passes as needed;
+ * the last pass writes output_path.
+ * Returns false if a file cannot be read or written. If stats is given
+ * it receives the record count, run and pass counts and timings.
+ */
+template <typename Record, typename Comparator>
+bool externalSort( const string & input_path, const string & output_path, Comparator less_than,
+                   const ExternalSortOptions & options, ExternalSortStats * stats = nullptr ) {
+    static_assert( is_trivially_copyable<Record>::value, "records are copied to and from files as bytes" );
+    ExternalSortStats local;
+    ExternalSortStats & s = stats != nullptr ? *stats : local;
+    s = ExternalSortStats( );
+
+    size_t budgetRecords = max<size_t>( options.memory_budget_bytes / sizeof( Record ), 1 );
+    size_t minBlockRecords = max<size_t>( kExternalSortMinBlockBytes / sizeof( Record ), 1 );
+
+    // Run phase
+    const auto runStart = chrono::steady_clock::now( );
+    FILE * input = fopen( input_path.c_str( ), "rb" );
+    if( input == nullptr )
+        return false;
+    vector<string> paths;
+    const string runPrefix = externalRunPrefix( options.temp_directory );
+    // Half the budget for the chunk, half for MergeSort's or RadixSort's buffer
+    bool ok = createRuns<Record>( input, max<size_t>( budgetRecords / 2, 1 ), options, runPrefix, less_than, paths, s );
+    fclose( input );
+    s.bytes = s.records * sizeof( Record );
+    s.run_seconds = chrono::duration<double>( chrono::steady_clock::now( ) - runStart ).count( );
+
+    // Merge phase: each merge needs 2 buffers per input run and 2 for output
+    const auto mergeStart = chrono::steady_clock::now( );
+    if( ok && paths.empty( ) ) {
+        FILE * output = fopen( output_path.c_str( ), "wb" );
+        ok = output != nullptr && fclose( output ) == 0;
+    }
+
+    size_t fanIn = max<size_t>( budgetRecords / minBlockRecords / 2, 3 ) - 1;
+    int nextRun = paths.size( );
+    while( ok && !paths.empty( ) ) {
+        bool last = paths.size( ) <= fanIn;
+        vector<string> merged;
+        for( size_t first = 0; first < paths.size( ); first += fanIn ) {
+            vector<string> group( paths.begin( ) + first, paths.begin( ) + min( paths.size( ), first + fanIn ) );
+            if( ok ) {
+                string target = last ? output_path : externalRunPath( runPrefix, nextRun++ );
+                size_t blockRecords = max<size_t>( budgetRecords / ( 2 * ( group.size( ) + 1 ) ), 1 );
+                ok = mergeRuns<Record>( group, target, blockRecords, less_than );
+                if( !last )
+                    merged.push_back( target );
+            }
+            for( const string & path : group )
+                remove( path.c_str( ) );
+        }
+        ++s.merge_passes;
+        paths.swap( merged );
+    }
+    s.merge_seconds = chrono::duration<double>( chrono::steady_clock::now( ) - mergeStart ).count( );
+
+    for( const string & path : paths )    // Left over only after an error
+        remove( path.c_str( ) );
+    return ok;
+}
+
+// Driver for external sort.
+// @input_path: binary file of Records to be sorted.
+// @output_path: file that receives the sorted Records.
+// @less_than: Comparator to be used.
+// @options: memory budget, temporary directory and stability.
+// @stats: if not null, receives record counts, timings and throughput.
+template <typename Record, typename Comparator>
+bool ExternalSort(const string &input_path, const string &output_path, Comparator less_than,
+                  const ExternalSortOptions &options = ExternalSortOptions(), ExternalSortStats *stats = nullptr) {
+    return externalSort<Record>(input_path, output_path, less_than, options, stats);
+}
+
+#endif
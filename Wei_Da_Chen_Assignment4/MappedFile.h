@@ -0,0 +1,111 @@
+/**
+ * Read-write memory mapping of a whole file (POSIX), so that its
+ * contents can be sorted in place through a Span without being copied
+ * into a vector.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "Sort.h"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+class MappedFile {
+  public:
+    /**
+     * Maps the file at path for reading and writing. Changes reach the
+     * file through sync, or when the mapping is closed.
+     * On failure isOpen is false and error describes the cause.
+     */
+    explicit MappedFile( const string & path ) {
+        fd = open( path.c_str( ), O_RDWR );
+        if( fd < 0 ) {
+            fail( "open" );
+            return;
+        }
+
+        struct stat info;
+        if( fstat( fd, &info ) != 0 ) {
+            fail( "fstat" );
+            return;
+        }
+        bytes = info.st_size;
+        if( bytes == 0 )
+            return;    // Nothing to map; an empty Span will do
+
+        address = mmap( nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        if( address == MAP_FAILED ) {
+            address = nullptr;
+            fail( "mmap" );
+        }
+    }
+
+    ~MappedFile( ) {
+        if( address != nullptr )
+            munmap( address, bytes );
+        if( fd >= 0 )
+            close( fd );
+    }
+
+    MappedFile( const MappedFile & ) = delete;
+    MappedFile & operator=( const MappedFile & ) = delete;
+
+    bool isOpen( ) const {
+        return fd >= 0;
+    }
+
+    const string & error( ) const {
+        return message;
+    }
+
+    // Size of the file in bytes.
+    size_t size( ) const {
+        return bytes;
+    }
+
+    /**
+     * The file viewed as an array of T. Trailing bytes that do not fill
+     * a whole T are left out.
+     */
+    template <typename T>
+    Span<T> span( ) const {
+        return Span<T>( static_cast<T *>( address ), bytes / sizeof( T ) );
+    }
+
+    /**
+     * Writes changes back to the file and waits for them to complete.
+     * Returns false on failure.
+     */
+    bool sync( ) {
+        if( address != nullptr && msync( address, bytes, MS_SYNC ) != 0 ) {
+            fail( "msync" );
+            return false;
+        }
+        return true;
+    }
+
+  private:
+    int fd = -1;
+    void * address = nullptr;
+    size_t bytes = 0;
+    string message;
+
+    void fail( const char * call ) {
+        message = string( call ) + ": " + strerror( errno );
+        if( address == nullptr && fd >= 0 ) {
+            close( fd );
+            fd = -1;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,166 @@
+/**
+ * Comparison and data-movement counting for the routines in Sort.h,
+ * none of which needs to change: sorting Counted<T> items with a
+ * CountingComparator counts every comparison, copy and move they make.
+ * A swap shows up as the three moves it is made of.
+ * Counting is chosen at compile time by a policy. Spelled through
+ * CountedFor and CountingComparatorFor, the types are the plain item and
+ * comparator under NoOperationCounts, so the same engines run as
+ * without instrumentation: radix and SIMD paths for std::less on
+ * integers, and memmove for trivially copyable items.
+ */
+
+#ifndef OPERATION_COUNTS_H
+#define OPERATION_COUNTS_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+// Numbers of operations made since the last reset.
+struct OperationCounts {
+    uint64_t comparisons;
+    uint64_t copies;    // Copy constructions and copy assignments
+    uint64_t moves;     // Move constructions and move assignments
+};
+
+/**
+ * Policy that counts, safely across the threads of the parallel sorts.
+ * The counters are shared by every Counted type and CountingComparator
+ * using this policy.
+ */
+class CountOperations {
+  public:
+    static const bool enabled = true;
+
+    static void comparison( ) {
+        counter( 0 ).fetch_add( 1, memory_order_relaxed );
+    }
+
+    static void copy( ) {
+        counter( 1 ).fetch_add( 1, memory_order_relaxed );
+    }
+
+    static void move( ) {
+        counter( 2 ).fetch_add( 1, memory_order_relaxed );
+    }
+
+    static OperationCounts read( ) {
+        return OperationCounts{ counter( 0 ).load( ), counter( 1 ).load( ), counter( 2 ).load( ) };
+    }
+
+    static void reset( ) {
+        for( int i = 0; i < 3; ++i )
+            counter( i ).store( 0 );
+    }
+
+  private:
+    static atomic<uint64_t> & counter( int i ) {
+        static atomic<uint64_t> counters[ 3 ];
+        return counters[ i ];
+    }
+};
+
+// Policy that counts nothing and costs nothing.
+struct NoOperationCounts {
+    static const bool enabled = false;
+
+    static void comparison( ) { }
+    static void copy( ) { }
+    static void move( ) { }
+
+    static OperationCounts read( ) {
+        return OperationCounts{ 0, 0, 0 };
+    }
+
+    static void reset( ) { }
+};
+
+/**
+ * Comparator that counts each call to less_than.
+ */
+template <typename Comparator, typename Policy = CountOperations>
+struct CountingComparator {
+    Comparator less_than;
+
+    template <typename A, typename B>
+    bool operator()( const A & lhs, const B & rhs ) const {
+        Policy::comparison( );
+        return less_than( lhs, rhs );
+    }
+};
+
+/**
+ * A T that counts its copies and moves. It compares like T, without
+ * counting; comparisons are counted by the comparator.
+ */
+template <typename T, typename Policy = CountOperations>
+class Counted {
+  public:
+    Counted( ) : value( ) { }
+    Counted( const T & x ) : value( x ) { }
+
+    Counted( const Counted & rhs ) : value( rhs.value ) {
+        Policy::copy( );
+    }
+
+    Counted( Counted && rhs ) : value( std::move( rhs.value ) ) {
+        Policy::move( );
+    }
+
+    Counted & operator=( const Counted & rhs ) {
+        Policy::copy( );
+        value = rhs.value;
+        return *this;
+    }
+
+    Counted & operator=( Counted && rhs ) {
+        Policy::move( );
+        value = std::move( rhs.value );
+        return *this;
+    }
+
+    const T & get( ) const {
+        return value;
+    }
+
+    bool operator<( const Counted & rhs ) const {
+        return value < rhs.value;
+    }
+
+    bool operator>( const Counted & rhs ) const {
+        return rhs.value < value;
+    }
+
+    bool operator==( const Counted & rhs ) const {
+        return value == rhs.value;
+    }
+
+    bool operator!=( const Counted & rhs ) const {
+        return !( value == rhs.value );
+    }
+
+  private:
+    T value;
+};
+
+/**
+ * The item and comparator types to sort with under Policy: the counting
+ * wrappers if it is enabled, and T and Comparator themselves if not.
+ */
+template <typename T, typename Policy = CountOperations>
+using CountedFor = typename conditional<Policy::enabled, Counted<T, Policy>, T>::type;
+
+template <typename Comparator, typename Policy = CountOperations>
+using CountingComparatorFor =
+    typename conditional<Policy::enabled, CountingComparator<Comparator, Policy>, Comparator>::type;
+
+static_assert( is_same<CountedFor<int, NoOperationCounts>, int>::value,
+               "uncounted items are the plain type" );
+static_assert( is_same<CountingComparatorFor<less<int>, NoOperationCounts>, less<int>>::value,
+               "an uncounting comparator is the plain comparator" );
+
+#endif
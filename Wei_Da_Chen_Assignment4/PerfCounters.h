@@ -0,0 +1,146 @@
+/**
+ * Hardware performance counters (Linux perf_event) for the calling
+ * thread and the threads it starts: cycles, instructions, branch
+ * misses, L1 data and last-level cache misses, and data TLB misses.
+ * Each counter is opened on its own, so those the CPU, the kernel or a
+ * virtual machine does not offer are left out without losing the rest.
+ * On other systems no counter is available.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+class PerfCounters {
+  public:
+    // One counter's name and its count between start and stop.
+    struct Reading {
+        string name;
+        double value;
+    };
+
+    /**
+     * Opens every counter that is available, counting user-space work
+     * of this thread and of threads it starts. If none is, available is
+     * false and error describes why the first one failed.
+     */
+    PerfCounters( ) {
+#ifdef __linux__
+        const uint64_t l1dReadMiss = PERF_COUNT_HW_CACHE_L1D | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) |
+                                     ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+        const uint64_t llcReadMiss = PERF_COUNT_HW_CACHE_LL | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) |
+                                     ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+        const uint64_t dtlbReadMiss = PERF_COUNT_HW_CACHE_DTLB | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) |
+                                      ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+        open( "Cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES );
+        open( "Instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS );
+        open( "Branch misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES );
+        open( "L1D misses", PERF_TYPE_HW_CACHE, l1dReadMiss );
+        open( "LLC misses", PERF_TYPE_HW_CACHE, llcReadMiss );
+        open( "dTLB misses", PERF_TYPE_HW_CACHE, dtlbReadMiss );
+#else
+        message = "perf_event is only available on Linux";
+#endif
+    }
+
+    ~PerfCounters( ) {
+#ifdef __linux__
+        for( const Counter & counter : counters )
+            close( counter.fd );
+#endif
+    }
+
+    PerfCounters( const PerfCounters & ) = delete;
+    PerfCounters & operator=( const PerfCounters & ) = delete;
+
+    bool available( ) const {
+        return !counters.empty( );
+    }
+
+    const string & error( ) const {
+        return message;
+    }
+
+    // Resets the counters and starts counting.
+    void start( ) {
+#ifdef __linux__
+        for( const Counter & counter : counters ) {
+            ioctl( counter.fd, PERF_EVENT_IOC_RESET, 0 );
+            ioctl( counter.fd, PERF_EVENT_IOC_ENABLE, 0 );
+        }
+#endif
+    }
+
+    // Stops counting.
+    void stop( ) {
+#ifdef __linux__
+        for( const Counter & counter : counters )
+            ioctl( counter.fd, PERF_EVENT_IOC_DISABLE, 0 );
+#endif
+    }
+
+    /**
+     * Returns the counts between the last start and stop. When the
+     * kernel had to share the hardware between more counters than it
+     * has, each count is scaled up from the time it was running.
+     * Counters that cannot be read are left out.
+     */
+    vector<Reading> read( ) const {
+        vector<Reading> readings;
+#ifdef __linux__
+        for( const Counter & counter : counters ) {
+            uint64_t values[ 3 ];    // Count, time enabled, time running
+            if( ::read( counter.fd, values, sizeof( values ) ) != sizeof( values ) || values[ 2 ] == 0 )
+                continue;
+            readings.push_back( Reading{ counter.name, double( values[ 0 ] ) * values[ 1 ] / values[ 2 ] } );
+        }
+#endif
+        return readings;
+    }
+
+  private:
+    struct Counter {
+        string name;
+        int fd;
+    };
+    vector<Counter> counters;
+    string message;
+
+#ifdef __linux__
+    void open( const char * name, uint32_t type, uint64_t config ) {
+        perf_event_attr attr;
+        memset( &attr, 0, sizeof( attr ) );
+        attr.size = sizeof( attr );
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;    // Also count threads started while counting
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        int fd = syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 );
+        if( fd < 0 ) {
+            if( message.empty( ) )
+                message = string( name ) + ": " + strerror( errno );
+            return;
+        }
+        counters.push_back( Counter{ name, fd } );
+    }
+#endif
+};
+
+#endif
@@ -20,13 +20,72 @@ each take a Comparator with their input.
 #include <iostream>
 #include <vector>
 #include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <string>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+#include <array>
+#include <memory>
 using namespace std;
 
+/**
+ * A view of size items stored contiguously at data, such as a vector's
+ * items or a memory-mapped file. It does not own them.
+ * The sorting routines below take any Array with value_type, size,
+ * data, begin, end and [] like vector, so a Span lets them sort
+ * memory in place that is not in a vector.
+ */
+template <typename T>
+class Span {
+  public:
+    typedef T value_type;
+
+    Span( ) : items( nullptr ), count( 0 ) { }
+    Span( T * data, size_t size ) : items( data ), count( size ) { }
+    Span( vector<T> & v ) : items( v.data( ) ), count( v.size( ) ) { }
+
+    size_t size( ) const {
+        return count;
+    }
+
+    bool empty( ) const {
+        return count == 0;
+    }
+
+    T * data( ) const {
+        return items;
+    }
+
+    T * begin( ) const {
+        return items;
+    }
+
+    T * end( ) const {
+        return items + count;
+    }
+
+    T & operator[]( size_t i ) const {
+        return items[ i ];
+    }
+
+  private:
+    T * items;
+    size_t count;
+};
+
 /**
  * Simple insertion sort.
  */
-template <typename Comparable, typename Comparator>
-void insertionSort( vector<Comparable> & a, Comparator less_than ) {
+template <typename Array, typename Comparator>
+void insertionSort( Array & a, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
     for (int p = 1; p < a.size( ); ++p) {
       Comparable tmp = std::move( a[ p ] );
       int j;
@@ -46,8 +105,9 @@ void insertionSort( vector<Comparable> & a, Comparator less_than ) {
  * left is the left-most index of the subarray.
  * right is the right-most index of the subarray.
  */
-template <typename Comparable, typename Comparator>
-void insertionSort( vector<Comparable> & a, int left, int right, Comparator less_than ) {
+template <typename Array, typename Comparator>
+void insertionSort( Array & a, int left, int right, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
     for (int p = left + 1; p <= right; ++p) {
       Comparable tmp = std::move( a[ p ] );
       int j;
@@ -60,6 +120,504 @@ void insertionSort( vector<Comparable> & a, int left, int right, Comparator less
     }
 }
 
+#if defined( __GNUC__ ) && !defined( __clang__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#include <immintrin.h>
+#define SORT_HAVE_SORTING_NETWORKS 1
+#else
+#define SORT_HAVE_SORTING_NETWORKS 0
+#endif
+
+/**
+ * Tells whether subarrays of Comparable ordered by Comparator can be
+ * sorted with the vectorized sorting networks below: the items must be
+ * 4 or 8 byte integers or floating point numbers, and the comparator
+ * std::less or std::greater. descending is set for std::greater.
+ */
+template <typename Comparable, bool Descending>
+struct NetworkSortableType
+    : integral_constant<bool, SORT_HAVE_SORTING_NETWORKS && is_arithmetic<Comparable>::value &&
+                              ( sizeof( Comparable ) == 4 || sizeof( Comparable ) == 8 )> {
+    static const bool descending = Descending;
+};
+
+template <typename Comparable, typename Comparator>
+struct NetworkSortable : false_type {
+    static const bool descending = false;
+};
+
+template <typename Comparable>
+struct NetworkSortable<Comparable, less<Comparable>> : NetworkSortableType<Comparable, false> { };
+
+template <typename Comparable>
+struct NetworkSortable<Comparable, greater<Comparable>> : NetworkSortableType<Comparable, true> { };
+
+#if __cplusplus >= 201402L
+template <typename Comparable>
+struct NetworkSortable<Comparable, less<>> : NetworkSortableType<Comparable, false> { };
+
+template <typename Comparable>
+struct NetworkSortable<Comparable, greater<>> : NetworkSortableType<Comparable, true> { };
+#endif
+
+/**
+ * Subarrays with at most this many items are not partitioned further
+ * by quicksort but finished by leafSort: 32 when a sorting network can
+ * sort them, 10 for insertionSort otherwise.
+ */
+template <typename Comparable, typename Comparator>
+struct QuickSortCutoff : integral_constant<int, NetworkSortable<Comparable, Comparator>::value ? 32 : 10> { };
+
+#if SORT_HAVE_SORTING_NETWORKS
+/**
+ * Internal types for the sorting networks: a GCC vector of Lanes items
+ * of type T, and the signed integer type of the same width used for
+ * lane indices and masks.
+ */
+template <typename T, int Lanes>
+struct NetworkVector {
+    typedef T type __attribute__(( vector_size( Lanes * sizeof( T ) ) ));
+};
+
+template <int Size>
+struct NetworkIndex;
+
+template <>
+struct NetworkIndex<4> {
+    typedef int32_t type;
+};
+
+template <>
+struct NetworkIndex<8> {
+    typedef int64_t type;
+};
+
+/**
+ * Internal method for the sorting networks that sets lanes to
+ * { 0, 1, ..., Lanes - 1 } as a constant the compiler can fold.
+ */
+template <typename IndexVector, int Lanes>
+struct NetworkLanes;
+
+template <typename IndexVector>
+struct NetworkLanes<IndexVector, 2> {
+    static inline __attribute__(( always_inline )) void get( IndexVector & lanes ) {
+        lanes = IndexVector{ 0, 1 };
+    }
+};
+
+template <typename IndexVector>
+struct NetworkLanes<IndexVector, 4> {
+    static inline __attribute__(( always_inline )) void get( IndexVector & lanes ) {
+        lanes = IndexVector{ 0, 1, 2, 3 };
+    }
+};
+
+template <typename IndexVector>
+struct NetworkLanes<IndexVector, 8> {
+    static inline __attribute__(( always_inline )) void get( IndexVector & lanes ) {
+        lanes = IndexVector{ 0, 1, 2, 3, 4, 5, 6, 7 };
+    }
+};
+
+/**
+ * Internal method for the sorting networks.
+ * One stage of a bitonic network over N items of type T held in
+ * registers of Bytes bytes: every item is compared with the item whose
+ * index differs in bit J and keeps the smaller or larger of the two,
+ * depending on its place in its bitonic block of size K. When J spans
+ * whole registers this is a plain min/max of two registers; otherwise
+ * the partner lanes are brought together with a constant shuffle and
+ * the results are blended. The two lanes of a pair make the same
+ * comparison from either side, so they always take opposite items,
+ * even ones equal but not identical such as 0.0 and -0.0. Each stage applies the next one, so the
+ * whole network is unrolled at compile time.
+ */
+template <typename T, int N, int Bytes, bool Descending, int K, int J, bool Done = ( K > N )>
+struct BitonicStage {
+    static const int kLanes = Bytes / sizeof( T );
+    static const int kRegisters = N / kLanes;
+    typedef typename NetworkVector<T, kLanes>::type Vector;
+    typedef typename NetworkVector<typename NetworkIndex<sizeof( T )>::type, kLanes>::type IndexVector;
+
+    static inline __attribute__(( always_inline )) void apply( Vector * v ) {
+        if( J >= kLanes ) {
+            for( int r = 0; r < kRegisters; ++r ) {
+                int p = r ^ ( J / kLanes );
+                if( p > r ) {
+                    bool ascending = ( ( ( r * kLanes ) & K ) == 0 ) != Descending;
+                    Vector smaller = v[ r ] < v[ p ] ? v[ r ] : v[ p ];
+                    Vector larger = v[ r ] < v[ p ] ? v[ p ] : v[ r ];
+                    v[ r ] = ascending ? smaller : larger;
+                    v[ p ] = ascending ? larger : smaller;
+                }
+            }
+        }
+        else {
+            IndexVector local;
+            NetworkLanes<IndexVector, kLanes>::get( local );
+            for( int r = 0; r < kRegisters; ++r ) {
+                IndexVector lane = local + r * kLanes;
+                Vector partner = __builtin_shuffle( v[ r ], local ^ J );
+                Vector smaller = v[ r ] < partner ? v[ r ] : partner;
+                Vector larger = partner < v[ r ] ? v[ r ] : partner;
+                IndexVector takeSmaller = ( ( lane & K ) == 0 ) == ( ( lane & J ) == 0 );
+                v[ r ] = ( Descending ? ~takeSmaller : takeSmaller ) ? smaller : larger;
+            }
+        }
+
+        BitonicStage<T, N, Bytes, Descending, ( J > 1 ? K : 2 * K ), ( J > 1 ? J / 2 : K )>::apply( v );
+    }
+};
+
+template <typename T, int N, int Bytes, bool Descending, int K, int J>
+struct BitonicStage<T, N, Bytes, Descending, K, J, true> {
+    template <typename Vector>
+    static inline __attribute__(( always_inline )) void apply( Vector * ) { }
+};
+
+/**
+ * Internal method that sorts the N items at data, N a power of two at
+ * least as large as a register, with a bitonic sorting network held in
+ * registers of Bytes bytes.
+ */
+template <typename T, int N, int Bytes, bool Descending>
+inline __attribute__(( always_inline )) void bitonicNetwork( T * data ) {
+    typedef typename NetworkVector<T, Bytes / sizeof( T )>::type Vector;
+    Vector v[ N * sizeof( T ) / Bytes ];
+
+    memcpy( v, data, sizeof( v ) );
+    BitonicStage<T, N, Bytes, Descending, 2, 1>::apply( v );
+    memcpy( data, v, sizeof( v ) );
+}
+
+/**
+ * Internal method that sorts count <= 32 items at data with the
+ * smallest 8, 16 or 32 item network that holds them, in registers of
+ * Bytes bytes. The network is padded with items that sort after every
+ * real one.
+ */
+template <typename T, int Bytes, bool Descending>
+inline __attribute__(( always_inline )) void sortingNetwork( T * data, int count ) {
+    const T padding = numeric_limits<T>::has_infinity
+                          ? ( Descending ? -numeric_limits<T>::infinity( ) : numeric_limits<T>::infinity( ) )
+                          : ( Descending ? numeric_limits<T>::lowest( ) : numeric_limits<T>::max( ) );
+    alignas( 32 ) T block[ 32 ];
+    memcpy( block, data, count * sizeof( T ) );
+
+    if( count <= 8 ) {
+        fill( block + count, block + 8, padding );
+        bitonicNetwork<T, 8, Bytes, Descending>( block );
+    }
+    else if( count <= 16 ) {
+        fill( block + count, block + 16, padding );
+        bitonicNetwork<T, 16, Bytes, Descending>( block );
+    }
+    else {
+        fill( block + count, block + 32, padding );
+        bitonicNetwork<T, 32, Bytes, Descending>( block );
+    }
+
+    memcpy( data, block, count * sizeof( T ) );
+}
+
+/**
+ * The sorting network compiled for 32-byte AVX2 registers and for
+ * 16-byte registers of the SSE2 baseline. leafSort picks one at run time.
+ */
+template <typename T, bool Descending>
+__attribute__(( target( "avx2" ) )) void sortingNetworkAVX2( T * data, int count ) {
+    sortingNetwork<T, 32, Descending>( data, count );
+}
+
+template <typename T, bool Descending>
+void sortingNetworkSSE( T * data, int count ) {
+    sortingNetwork<T, 16, Descending>( data, count );
+}
+#endif
+
+/**
+ * Internal method that finishes a small subarray of quicksort.
+ * a[left..right] holds at most QuickSortCutoff items. Sorting networks
+ * are used when NetworkSortable allows, insertionSort otherwise.
+ */
+template <typename Array, typename Comparator>
+void leafSort( Array & a, int left, int right, Comparator less_than, false_type ) {
+    insertionSort( a, left, right, less_than );
+}
+
+#if SORT_HAVE_SORTING_NETWORKS
+template <typename Array, typename Comparator>
+void leafSort( Array & a, int left, int right, Comparator, true_type ) {
+    typedef typename Array::value_type Comparable;
+    static const bool hasAVX2 = __builtin_cpu_supports( "avx2" );
+    const bool descending = NetworkSortable<Comparable, Comparator>::descending;
+
+    if( left >= right )
+        return;
+    if( hasAVX2 )
+        sortingNetworkAVX2<Comparable, descending>( &a[ left ], right - left + 1 );
+    else
+        sortingNetworkSSE<Comparable, descending>( &a[ left ], right - left + 1 );
+}
+#endif
+
+template <typename Array, typename Comparator>
+void leafSort( Array & a, int left, int right, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    leafSort( a, left, right, less_than, integral_constant<bool, NetworkSortable<Comparable, Comparator>::value>( ) );
+}
+
+/**
+ * Subarrays shorter than this are partitioned by the scalar loops even
+ * when simdPartition could handle them.
+ */
+const int kSimdPartitionCutoff = 128;
+
+#if SORT_HAVE_SORTING_NETWORKS
+/**
+ * Internal table for simdPartition.
+ * For every mask of Lanes bits, the lane order that packs the lanes
+ * whose bit is set first and the others after them, both in order.
+ */
+template <typename Index, int Lanes>
+struct CompressTable {
+    Index permutation[ 1 << Lanes ][ Lanes ];
+
+    CompressTable( ) {
+        for( int mask = 0; mask < ( 1 << Lanes ); ++mask ) {
+            int k = 0;
+            for( int lane = 0; lane < Lanes; ++lane )
+                if( mask & ( 1 << lane ) )
+                    permutation[ mask ][ k++ ] = lane;
+            for( int lane = 0; lane < Lanes; ++lane )
+                if( !( mask & ( 1 << lane ) ) )
+                    permutation[ mask ][ k++ ] = lane;
+        }
+    }
+
+    static const CompressTable & get( ) {
+        static const CompressTable table;
+        return table;
+    }
+};
+
+/**
+ * Internal method for simdPartition.
+ * Compares every lane of v with the broadcast pivot and sets goesLeft
+ * to all ones in the lanes that belong on the left, zero elsewhere:
+ * items before the pivot if Strict, items not after it otherwise.
+ */
+template <bool Descending, bool Strict, typename Vector, typename IndexVector>
+inline void partitionMask( const Vector & v, const Vector & pivots, IndexVector & goesLeft ) {
+    if( Strict )
+        goesLeft = Descending ? pivots < v : v < pivots;
+    else
+        goesLeft = Descending ? pivots <= v : v <= pivots;
+}
+
+/**
+ * Internal method for simdPartition that finishes the partition with
+ * scalar code: the count items at items go to writeLeft or writeRight.
+ */
+template <typename T, bool Descending, bool Strict>
+void partitionScalar( T * data, const T * items, int count, T pivot, int & writeLeft, int & writeRight ) {
+    for( int i = 0; i < count; ++i ) {
+        T x = items[ i ];
+        bool goesLeft = Strict ? ( Descending ? pivot < x : x < pivot ) : ( Descending ? !( x < pivot ) : !( pivot < x ) );
+        if( goesLeft )
+            data[ writeLeft++ ] = x;
+        else
+            data[ --writeRight ] = x;
+    }
+}
+
+/**
+ * Internal method for simdPartition.
+ * Picks the next register of items to split off data[readLeft..readRight - 1].
+ * The first and last registers are loaded up front, which leaves a
+ * register's worth of free space at each end. Each further register is
+ * read from the end with less free space, so the caller can store a
+ * whole register at writeLeft and one ending at writeRight without
+ * overwriting unread items. Once fewer than a register's worth are
+ * left they are copied to rest together with last, which opens up the
+ * gap between the write positions, and first is handed out.
+ * Returns false when there is nothing left but rest.
+ */
+template <typename T, typename Vector>
+bool nextPartitionRegister( T * data, Vector & v, const Vector & first, const Vector & last,
+                            int & readLeft, int & readRight, int writeLeft, int writeRight,
+                            T * rest, int & restCount ) {
+    const int kLanes = sizeof( Vector ) / sizeof( T );
+    if( readRight - readLeft >= kLanes ) {
+        if( readLeft - writeLeft <= writeRight - readRight ) {
+            memcpy( &v, data + readLeft, sizeof( v ) );
+            readLeft += kLanes;
+        }
+        else {
+            readRight -= kLanes;
+            memcpy( &v, data + readRight, sizeof( v ) );
+        }
+        return true;
+    }
+    if( restCount >= 0 )
+        return false;
+
+    restCount = readRight - readLeft;
+    memcpy( rest, data + readLeft, restCount * sizeof( T ) );
+    memcpy( rest + restCount, &last, sizeof( last ) );
+    restCount += kLanes;
+    readLeft = readRight;
+    v = first;
+    return true;
+}
+
+/**
+ * Internal in-place partition of the n >= 2 * 32 / sizeof(T) items at
+ * data with AVX2. Items that partitionMask sends left are packed to the
+ * front of each register with a permutation from CompressTable, the
+ * others after them, and the whole register is stored at both ends.
+ * Returns the number of items placed on the left.
+ */
+template <typename T, bool Descending, bool Strict>
+__attribute__(( target( "avx2" ) )) int simdPartitionAVX2( T * data, int n, T pivot ) {
+    const int kLanes = 32 / sizeof( T );
+    typedef typename NetworkVector<T, kLanes>::type Vector;
+    typedef typename NetworkIndex<sizeof( T )>::type Index;
+    typedef typename NetworkVector<Index, kLanes>::type IndexVector;
+    const CompressTable<Index, kLanes> & table = CompressTable<Index, kLanes>::get( );
+
+    Vector pivots = Vector{ } + pivot;
+    Vector v, first, last;
+    memcpy( &first, data, sizeof( first ) );
+    memcpy( &last, data + n - kLanes, sizeof( last ) );
+    int readLeft = kLanes, readRight = n - kLanes;
+    int writeLeft = 0, writeRight = n;
+    T rest[ 2 * kLanes ];
+    int restCount = -1;
+
+    while( nextPartitionRegister( data, v, first, last, readLeft, readRight, writeLeft, writeRight, rest, restCount ) ) {
+        IndexVector goesLeft;
+        partitionMask<Descending, Strict>( v, pivots, goesLeft );
+        int mask = sizeof( T ) == 4 ? _mm256_movemask_ps( ( __m256 ) goesLeft ) : _mm256_movemask_pd( ( __m256d ) goesLeft );
+        int numLeft = __builtin_popcount( mask );
+
+        IndexVector order;
+        memcpy( &order, table.permutation[ mask ], sizeof( order ) );
+        Vector packed = __builtin_shuffle( v, order );
+        memcpy( data + writeLeft, &packed, sizeof( packed ) );
+        memcpy( data + writeRight - kLanes, &packed, sizeof( packed ) );
+        writeLeft += numLeft;
+        writeRight -= kLanes - numLeft;
+    }
+
+    partitionScalar<T, Descending, Strict>( data, rest, restCount, pivot, writeLeft, writeRight );
+    return writeLeft;
+}
+
+/**
+ * Internal in-place partition of the n >= 2 * 64 / sizeof(T) items at
+ * data with AVX-512. Like simdPartitionAVX2, but the compress stores
+ * write only the lanes of each part.
+ */
+template <typename T, bool Descending, bool Strict>
+__attribute__(( target( "avx512f" ) )) int simdPartitionAVX512( T * data, int n, T pivot ) {
+    const int kLanes = 64 / sizeof( T );
+    typedef typename NetworkVector<T, kLanes>::type Vector;
+    typedef typename NetworkIndex<sizeof( T )>::type Index;
+    typedef typename NetworkVector<Index, kLanes>::type IndexVector;
+
+    Vector pivots = Vector{ } + pivot;
+    Vector v, first, last;
+    memcpy( &first, data, sizeof( first ) );
+    memcpy( &last, data + n - kLanes, sizeof( last ) );
+    int readLeft = kLanes, readRight = n - kLanes;
+    int writeLeft = 0, writeRight = n;
+    T rest[ 2 * kLanes ];
+    int restCount = -1;
+
+    while( nextPartitionRegister( data, v, first, last, readLeft, readRight, writeLeft, writeRight, rest, restCount ) ) {
+        IndexVector goesLeft;
+        partitionMask<Descending, Strict>( v, pivots, goesLeft );
+        int numLeft;
+        if( sizeof( T ) == 4 ) {
+            __mmask16 mask = _mm512_test_epi32_mask( ( __m512i ) goesLeft, ( __m512i ) goesLeft );
+            numLeft = __builtin_popcount( mask );
+            _mm512_mask_compressstoreu_epi32( data + writeLeft, mask, ( __m512i ) v );
+            _mm512_mask_compressstoreu_epi32( data + writeRight - ( kLanes - numLeft ), ( __mmask16 ) ~mask, ( __m512i ) v );
+        }
+        else {
+            __mmask8 mask = _mm512_test_epi64_mask( ( __m512i ) goesLeft, ( __m512i ) goesLeft );
+            numLeft = __builtin_popcount( mask );
+            _mm512_mask_compressstoreu_epi64( data + writeLeft, mask, ( __m512i ) v );
+            _mm512_mask_compressstoreu_epi64( data + writeRight - ( kLanes - numLeft ), ( __mmask8 ) ~mask, ( __m512i ) v );
+        }
+        writeLeft += numLeft;
+        writeRight -= kLanes - numLeft;
+    }
+
+    partitionScalar<T, Descending, Strict>( data, rest, restCount, pivot, writeLeft, writeRight );
+    return writeLeft;
+}
+
+/**
+ * Internal method for simdPartition.
+ * Returns 2 if the CPU has AVX-512, 1 if it has AVX2 and 0 otherwise.
+ */
+inline int simdPartitionLevel( ) {
+    static const int level = __builtin_cpu_supports( "avx512f" ) ? 2 : __builtin_cpu_supports( "avx2" ) ? 1 : 0;
+    return level;
+}
+#endif
+
+/**
+ * Internal method that partitions a[left..right] around pivot with
+ * vector instructions, for the item types and comparators that
+ * NetworkSortable accepts. The pivot must not be in a[left..right].
+ * Items before the pivot are moved to the left. If there are none,
+ * the items equal to the pivot are moved there instead and
+ * leftEqualsPivot is set, so the caller need not sort them.
+ * boundary is set to the first index of the right part.
+ * Returns false, without touching a, if the CPU has neither AVX2 nor
+ * AVX-512 or the subarray is short; the caller then uses its scalar loop.
+ */
+template <typename Array, typename Comparator>
+bool simdPartition( Array &, int, int, const typename Array::value_type &, Comparator, int &, bool &, false_type ) {
+    return false;
+}
+
+#if SORT_HAVE_SORTING_NETWORKS
+template <typename Array, typename Comparator>
+bool simdPartition( Array & a, int left, int right, const typename Array::value_type & pivot, Comparator,
+                    int & boundary, bool & leftEqualsPivot, true_type ) {
+    typedef typename Array::value_type Comparable;
+    const bool descending = NetworkSortable<Comparable, Comparator>::descending;
+    const int level = simdPartitionLevel( );
+    const int n = right - left + 1;
+    if( level == 0 || n < kSimdPartitionCutoff )
+        return false;
+
+    Comparable * data = &a[ left ];
+    int numLeft = level == 2 ? simdPartitionAVX512<Comparable, descending, true>( data, n, pivot )
+                             : simdPartitionAVX2<Comparable, descending, true>( data, n, pivot );
+    leftEqualsPivot = numLeft == 0;
+    if( leftEqualsPivot ) {
+        numLeft = level == 2 ? simdPartitionAVX512<Comparable, descending, false>( data, n, pivot )
+                             : simdPartitionAVX2<Comparable, descending, false>( data, n, pivot );
+    }
+
+    boundary = left + numLeft;
+    return true;
+}
+#endif
+
+template <typename Array, typename Comparator>
+bool simdPartition( Array & a, int left, int right, const typename Array::value_type & pivot, Comparator less_than,
+                    int & boundary, bool & leftEqualsPivot ) {
+    typedef typename Array::value_type Comparable;
+    return simdPartition( a, left, right, pivot, less_than, boundary, leftEqualsPivot,
+                          integral_constant<bool, NetworkSortable<Comparable, Comparator>::value>( ) );
+}
+
 /**
  * Shellsort, using Shell's (poor) increments.
  */
@@ -94,8 +652,9 @@ inline int leftChild( int i ) {
  * i is the position from which to percolate down.
  * n is the logical size of the binary heap.
  */
-template <typename Comparable, typename Comparator>
-void percDown( vector<Comparable> & a, int i, int n, Comparator less_than) {
+template <typename Array, typename Comparator>
+void percDown( Array & a, int i, int n, Comparator less_than) {
+  typedef typename Array::value_type Comparable;
   int child;
   Comparable tmp;
 
@@ -119,8 +678,8 @@ void percDown( vector<Comparable> & a, int i, int n, Comparator less_than) {
 /**
  * Standard heapsort.
  */
-template <typename Comparable, typename Comparator>
-void heapsort( vector<Comparable> & a, Comparator less_than ) {
+template <typename Array, typename Comparator>
+void heapsort( Array & a, Comparator less_than ) {
   // buildHeap
   for (int i = a.size( ) / 2 - 1; i >= 0; --i) {
     percDown( a, i, a.size( ), less_than );
@@ -133,6 +692,150 @@ void heapsort( vector<Comparable> & a, Comparator less_than ) {
   }
 }
 
+/**
+ * Internal method for heapsort on a subarray.
+ * The heap is stored in a[offset..offset+n-1]; i and n are
+ * relative to offset exactly as in percDown above.
+ */
+template <typename Array, typename Comparator>
+void percDown( Array & a, int offset, int i, int n, Comparator less_than) {
+  typedef typename Array::value_type Comparable;
+  int child;
+  Comparable tmp;
+
+  for( tmp = std::move( a[ offset + i ] ); leftChild( i ) < n; i = child ) {
+    child = leftChild( i );
+
+    if( child != n - 1 && (less_than(a[offset + child], a[offset + child + 1]))) {
+      ++child;
+    }
+    if(less_than(tmp, a[offset + child])) {
+      a[ offset + i ] = std::move( a[ offset + child ] );
+    }
+    else {
+      break;
+    }
+  }
+
+  a[ offset + i ] = move( tmp );
+}
+
+/**
+ * Heapsort for the subarray a[left..right].
+ */
+template <typename Array, typename Comparator>
+void heapsort( Array & a, int left, int right, Comparator less_than ) {
+  int n = right - left + 1;
+
+  // buildHeap
+  for (int i = n / 2 - 1; i >= 0; --i) {
+    percDown( a, left, i, n, less_than );
+  }
+
+  // deleteMax
+  for( int j = n - 1; j > 0; --j ) {
+    swap( a[ left ], a[ left + j ] );
+    percDown( a, left, 0, j, less_than );
+  }
+}
+
+/**
+ * Internal method for the d-ary heapsort.
+ * i is the index of an item in a heap where every node has Arity
+ * children. Returns the index of its first child.
+ */
+template <int Arity>
+inline int dAryChild( int i ) {
+    return Arity * i + 1;
+}
+
+/**
+ * Size in bytes of the cache lines prefetched by the d-ary heapsort.
+ */
+const int kCacheLineBytes = 64;
+
+/**
+ * Internal method for the d-ary heapsort.
+ * Asks the CPU to start loading the children of a[first..last], which
+ * are contiguous, one cache line at a time, so they are in cache by the
+ * time the sift-down reaches them.
+ * Does nothing on compilers without __builtin_prefetch.
+ */
+template <int Arity, typename Array>
+inline void prefetchChildren( const Array & a, int first, int last, int n ) {
+#if defined( __GNUC__ )
+    int begin = dAryChild<Arity>( first );
+    if( begin >= n )
+        return;
+    int end = min( dAryChild<Arity>( last ) + Arity, n );
+    const char * line = reinterpret_cast<const char *>( &a[ begin ] );
+    const char * stop = reinterpret_cast<const char *>( &a[ end - 1 ] ) + sizeof( a[ 0 ] );
+    for( ; line < stop; line += kCacheLineBytes )
+        __builtin_prefetch( line );
+#endif
+}
+
+/**
+ * Internal method for the d-ary heapsort, using Floyd's bottom-up
+ * sift-down. Instead of comparing a[i] with the largest child at every
+ * level, the hole at i is first moved down to a leaf along the path of
+ * largest children, which takes only Arity - 1 comparisons per level;
+ * a[i] is then sifted up from there, which usually stops after a level
+ * or two. The grandchildren of the hole, which are contiguous, are
+ * prefetched one level ahead, every cache line of them.
+ * i is the position from which to percolate down.
+ * n is the logical size of the heap.
+ */
+template <int Arity, typename Array, typename Comparator>
+void dAryPercDown( Array & a, int i, int n, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    Comparable tmp = std::move( a[ i ] );
+    int hole = i;
+
+    for( int child; ( child = dAryChild<Arity>( hole ) ) < n; ) {
+        int last = min( child + Arity, n );
+        prefetchChildren<Arity>( a, child, last - 1, n );
+
+        int largest = child;
+        for( int k = child + 1; k < last; ++k )
+            largest = less_than( a[ largest ], a[ k ] ) ? k : largest;
+
+        a[ hole ] = std::move( a[ largest ] );
+        hole = largest;
+    }
+
+    while( hole > i ) {
+        int parent = ( hole - 1 ) / Arity;
+        if( !less_than( a[ parent ], tmp ) )
+            break;
+        a[ hole ] = std::move( a[ parent ] );
+        hole = parent;
+    }
+    a[ hole ] = std::move( tmp );
+}
+
+/**
+ * Heapsort with a d-ary heap of the given Arity (4 or 8 are sensible).
+ * A node's children are adjacent, so with small items they share a
+ * cache line, and the heap is log2(Arity) times shallower than a
+ * binary one. Sift-downs use dAryPercDown.
+ */
+template <int Arity, typename Array, typename Comparator>
+void dAryHeapsort( Array & a, Comparator less_than ) {
+    static_assert( Arity >= 2, "a heap node needs at least two children" );
+    int n = a.size( );
+
+    // buildHeap
+    for( int i = ( n - 2 ) / Arity; i >= 0 && n > 1; --i )
+        dAryPercDown<Arity>( a, i, n, less_than );
+
+    // deleteMax
+    for( int j = n - 1; j > 0; --j ) {
+        std::swap( a[ 0 ], a[ j ] );
+        dAryPercDown<Arity>( a, 0, j, less_than );
+    }
+}
+
 /**
  * Internal method that merges two sorted halves of a subarray.
  * a is an array of Comparable items.
@@ -140,19 +843,20 @@ void heapsort( vector<Comparable> & a, Comparator less_than ) {
  * leftPos is the left-most index of the subarray.
  * rightPos is the index of the start of the second half.
  * rightEnd is the right-most index of the subarray.
+ * Ties are taken from the first half, which keeps mergesort stable.
  */
-template <typename Comparable, typename Comparator>
-void merge(vector<Comparable> & a, vector<Comparable> & tmpArray, int leftPos, int rightPos, int rightEnd, Comparator less_than) {
+template <typename Array, typename Buffer, typename Comparator>
+void merge(Array & a, Buffer & tmpArray, int leftPos, int rightPos, int rightEnd, Comparator less_than) {
     int leftEnd = rightPos - 1;
     int tmpPos = leftPos;
     int numElements = rightEnd - leftPos + 1;
 
     // Main loop
     while( leftPos <= leftEnd && rightPos <= rightEnd )
-        if(less_than(a[ leftPos ], a[ rightPos ]))
-            tmpArray[ tmpPos++ ] = std::move( a[ leftPos++ ] );
-        else
+        if(less_than(a[ rightPos ], a[ leftPos ]))
             tmpArray[ tmpPos++ ] = std::move( a[ rightPos++ ] );
+        else
+            tmpArray[ tmpPos++ ] = std::move( a[ leftPos++ ] );
 
     while( leftPos <= leftEnd )    // Copy rest of first half
         tmpArray[ tmpPos++ ] = std::move( a[ leftPos++ ] );
@@ -172,323 +876,2876 @@ void merge(vector<Comparable> & a, vector<Comparable> & tmpArray, int leftPos, i
  * left is the left-most index of the subarray.
  * right is the right-most index of the subarray.
  */
-template <typename Comparable, typename Comparator>
-void mergeSort(vector<Comparable> & a, vector<Comparable> & tmpArray, int left, int right, Comparator less_than) {
+template <typename Array, typename Buffer, typename Comparator>
+void mergeSort(Array & a, Buffer & tmpArray, int left, int right, Comparator less_than) {
     if (left < right) {
       int center = ( left + right ) / 2;
       mergeSort( a, tmpArray, left, center, less_than );
       mergeSort( a, tmpArray, center + 1, right, less_than );
-      merge( a, tmpArray, left, center + 1, right, less_than );
+      ::merge( a, tmpArray, left, center + 1, right, less_than );  // Not std::merge, which ADL also finds
     }
 }
 
 /**
  * Mergesort algorithm (driver).
  */
-template <typename Comparable, typename Comparator>
-void mergeSort( vector<Comparable> & a, Comparator less_than ) {
+template <typename Array, typename Comparator>
+void mergeSort( Array & a, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
     vector<Comparable> tmpArray( a.size( ) );
     mergeSort( a, tmpArray, 0, a.size( ) - 1, less_than );
 }
 
 /**
- * Return median of left, center, and right.
- * Order these and hide the pivot.
+ * Subarrays with at most this many items are handled by a single thread
+ * in the parallel mergesort; below it thread start-up costs more than it saves.
  */
-template <typename Comparable, typename Comparator>
-const Comparable & median3( vector<Comparable> & a, int left, int right, Comparator less_than ) {
-    int center = ( left + right ) / 2;
+const int kParallelMergeSortCutoff = 1 << 14;
 
-    if( less_than(a[ center ], a[ left ]))
-        std::swap( a[ left ], a[ center ] );
-    if( less_than(a[ right ], a[ left ]))
-        std::swap( a[ left ], a[ right ] );
-    if( less_than(a[ right ], a[ center ]))
-        std::swap( a[ center ], a[ right ] );
+/**
+ * Internal method that merges a[leftPos..leftEnd] and a[rightPos..rightEnd]
+ * into tmpArray starting at tmpPos. Nothing is copied back into a.
+ * Ties are taken from the left run first.
+ */
+template <typename Array, typename Buffer, typename Comparator>
+void mergeInto(Array & a, Buffer & tmpArray, int leftPos, int leftEnd,
+               int rightPos, int rightEnd, int tmpPos, Comparator less_than) {
+    while( leftPos <= leftEnd && rightPos <= rightEnd )
+        if(less_than(a[ rightPos ], a[ leftPos ]))
+            tmpArray[ tmpPos++ ] = std::move( a[ rightPos++ ] );
+        else
+            tmpArray[ tmpPos++ ] = std::move( a[ leftPos++ ] );
 
-    // Place pivot at position right - 1
-    std::swap( a[ center ], a[ right - 1 ] );
-    return a[ right - 1 ];
+    while( leftPos <= leftEnd )
+        tmpArray[ tmpPos++ ] = std::move( a[ leftPos++ ] );
+
+    while( rightPos <= rightEnd )
+        tmpArray[ tmpPos++ ] = std::move( a[ rightPos++ ] );
 }
 
 /**
- * Internal quicksort method that makes recursive calls.
- * Uses median-of-three partitioning and a cutoff of 10.
- * a is an array of Comparable items.
- * left is the left-most index of the subarray.
- * right is the right-most index of the subarray.
+ * Internal method that merges two sorted runs into tmpArray using up to
+ * threads threads. The middle item of the longer run is located in the
+ * other run by binary search, which splits the merge into two independent
+ * halves that are merged in parallel.
  */
-template <typename Comparable, typename Comparator>
-void quicksort( vector<Comparable> & a, int left, int right, Comparator less_than ) {
-    if( left + 10 <= right ) {
-                // cout<<endl<<"quicksort1 left: "<<left;
-        const Comparable & pivot = median3( a, left, right, less_than );
+template <typename Array, typename Buffer, typename Comparator>
+void parallelMerge(Array & a, Buffer & tmpArray, int leftPos, int leftEnd,
+                   int rightPos, int rightEnd, int tmpPos, Comparator less_than, int threads) {
+    int leftSize = leftEnd - leftPos + 1;
+    int rightSize = rightEnd - rightPos + 1;
+
+    if( threads <= 1 || leftSize + rightSize <= kParallelMergeSortCutoff ) {
+        mergeInto( a, tmpArray, leftPos, leftEnd, rightPos, rightEnd, tmpPos, less_than );
+        return;
+    }
 
-            // Begin partitioning
-        int i = left, j = right - 1;
-        for( ; ; ) {
-            while(less_than(a[ ++i ],pivot)) { }
-            while(less_than(pivot, a[ --j ])) { }
-            if( i < j )
-                std::swap( a[ i ], a[ j ] );
+    int leftSplit, rightSplit;
+    if( leftSize >= rightSize ) {
+        // Right items smaller than the left middle go before it.
+        leftSplit = ( leftPos + leftEnd ) / 2;
+        int low = rightPos, high = rightEnd + 1;
+        while( low < high ) {
+            int mid = low + ( high - low ) / 2;
+            if( less_than( a[ mid ], a[ leftSplit ] ) )
+                low = mid + 1;
             else
-                break;
+                high = mid;
+        }
+        rightSplit = low;
+    }
+    else {
+        // Left items not greater than the right middle go before it.
+        rightSplit = ( rightPos + rightEnd ) / 2;
+        int low = leftPos, high = leftEnd + 1;
+        while( low < high ) {
+            int mid = low + ( high - low ) / 2;
+            if( less_than( a[ rightSplit ], a[ mid ] ) )
+                high = mid;
+            else
+                low = mid + 1;
         }
+        leftSplit = low;
+    }
 
-        std::swap( a[ i ], a[ right - 1 ] );  // Restore pivot
+    // a[leftPos..leftSplit-1] and a[rightPos..rightSplit-1] form the first half.
+    int secondPos = tmpPos + ( leftSplit - leftPos ) + ( rightSplit - rightPos );
+    thread first( [&]( ) {
+        parallelMerge( a, tmpArray, leftPos, leftSplit - 1, rightPos, rightSplit - 1,
+                       tmpPos, less_than, threads / 2 );
+    } );
+    parallelMerge( a, tmpArray, leftSplit, leftEnd, rightSplit, rightEnd,
+                   secondPos, less_than, threads - threads / 2 );
+    first.join( );
+}
 
-        quicksort( a, left, i - 1, less_than );     // Sort small elements
-        quicksort( a, i + 1, right, less_than );    // Sort large elements
-    }
-    else  // Do an insertion sort on the subarray
+/**
+ * Internal method that moves tmpArray[left..right] back into a
+ * using up to threads threads.
+ */
+template <typename Array, typename Buffer>
+void parallelCopyBack(Array & a, Buffer & tmpArray, int left, int right, int threads) {
+    if( threads <= 1 || right - left < kParallelMergeSortCutoff ) {
+        std::move( tmpArray.begin( ) + left, tmpArray.begin( ) + right + 1, a.begin( ) + left );
+        return;
+    }
+
+    int center = ( left + right ) / 2;
+    thread first( [&]( ) { parallelCopyBack( a, tmpArray, left, center, threads / 2 ); } );
+    parallelCopyBack( a, tmpArray, center + 1, right, threads - threads / 2 );
+    first.join( );
+}
+
+/**
+ * Internal method that makes recursive calls, sorting the two halves
+ * as parallel tasks. Both halves share the single tmpArray since they
+ * touch disjoint parts of it.
+ * a is an array of Comparable items.
+ * tmpArray is an array to place the merged result.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ * threads is the number of threads this subarray may use.
+ */
+template <typename Array, typename Buffer, typename Comparator>
+void parallelMergeSort(Array & a, Buffer & tmpArray, int left, int right,
+                       Comparator less_than, int threads) {
+    if( threads <= 1 || right - left < kParallelMergeSortCutoff ) {
+        mergeSort( a, tmpArray, left, right, less_than );
+        return;
+    }
+
+    int center = ( left + right ) / 2;
+    thread first( [&]( ) { parallelMergeSort( a, tmpArray, left, center, less_than, threads / 2 ); } );
+    parallelMergeSort( a, tmpArray, center + 1, right, less_than, threads - threads / 2 );
+    first.join( );
+
+    parallelMerge( a, tmpArray, left, center, center + 1, right, left, less_than, threads );
+    parallelCopyBack( a, tmpArray, left, right, threads );
+}
+
+/**
+ * Returns the number of threads to use when the caller asked for
+ * num_threads; 0 means one per hardware thread.
+ */
+inline int sortThreadCount( int num_threads ) {
+    if( num_threads > 0 )
+        return num_threads;
+    int hardware = static_cast<int>( thread::hardware_concurrency( ) );
+    return hardware > 0 ? hardware : 1;
+}
+
+/**
+ * Length of the runs that the bottom-up mergesort sorts with insertion
+ * sort before the first merge pass.
+ */
+const int kMergeSortRunSize = 32;
+
+/**
+ * Bottom-up mergesort algorithm (driver).
+ * Runs of kMergeSortRunSize items are sorted by insertion sort, then
+ * merged in passes of doubling width. Each pass merges from one buffer
+ * into the other with mergeInto and the two swap roles, so nothing is
+ * copied back after a merge; if the last pass ends in tmpArray its
+ * contents are moved back into a once. Stable, and not recursive.
+ */
+template <typename Array, typename Comparator>
+void mergeSortBottomUp( Array & a, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    int n = a.size( );
+    for( int left = 0; left < n; left += kMergeSortRunSize )
+        insertionSort( a, left, min( left + kMergeSortRunSize, n ) - 1, less_than );
+    if( n <= kMergeSortRunSize )
+        return;
+
+    vector<Comparable> tmpArray( n );
+    Span<Comparable> source( a.data( ), n );
+    Span<Comparable> target( tmpArray.data( ), n );
+    for( int width = kMergeSortRunSize; width < n; width *= 2 ) {
+        for( int left = 0; left < n; left += 2 * width ) {
+            int center = min( left + width, n );
+            int right = min( left + 2 * width, n ) - 1;
+            mergeInto( source, target, left, center - 1, center, right, left, less_than );
+        }
+        std::swap( source, target );
+    }
+
+    if( source.data( ) != a.data( ) )
+        std::move( tmpArray.begin( ), tmpArray.end( ), a.begin( ) );
+}
+
+/**
+ * Runs shorter than this are extended with insertion sort by timSort;
+ * see timSortMinRun.
+ */
+const int kTimSortMinMerge = 32;
+
+/**
+ * Number of consecutive wins by one run after which timSort's merges
+ * switch to galloping. It adapts up and down from here during a sort.
+ */
+const int kTimSortMinGallop = 7;
+
+/**
+ * Internal state of timSort: the stack of pending runs (their base
+ * index and length), the merge buffer, and the current gallop threshold.
+ */
+template <typename Comparable>
+struct TimSortState {
+    vector<int> runBase;
+    vector<int> runLength;
+    vector<Comparable> tmpArray;
+    int minGallop = kTimSortMinGallop;
+};
+
+/**
+ * Internal method for timSort.
+ * Returns the minimum run length for an array of n items, chosen in
+ * [kTimSortMinMerge / 2, kTimSortMinMerge] so that n / minRun is a
+ * power of two or a little less, which keeps the final merges balanced.
+ */
+inline int timSortMinRun( int n ) {
+    int lowBits = 0;
+    while( n >= kTimSortMinMerge ) {
+        lowBits |= n & 1;
+        n >>= 1;
+    }
+    return n + lowBits;
+}
+
+/**
+ * Internal method for timSort.
+ * Returns the length of the run starting at a[left], scanning no
+ * further than a[right]. A strictly descending run is reversed in
+ * place; requiring strictness keeps the sort stable.
+ */
+template <typename Array, typename Comparator>
+int countRunAndMakeAscending( Array & a, int left, int right, Comparator less_than ) {
+    int end = left + 1;
+    if( end > right )
+        return 1;
+
+    if( less_than( a[ end++ ], a[ left ] ) ) {
+        while( end <= right && less_than( a[ end ], a[ end - 1 ] ) )
+            ++end;
+        std::reverse( a.begin( ) + left, a.begin( ) + end );
+    }
+    else {
+        while( end <= right && !less_than( a[ end ], a[ end - 1 ] ) )
+            ++end;
+    }
+    return end - left;
+}
+
+/**
+ * Internal method for timSort.
+ * Locates key in the sorted v[base..base + length - 1], starting the
+ * search at v[base + hint] and galloping away from it in steps of
+ * 1, 3, 7, ... before finishing with a binary search.
+ * Returns the leftmost position k at which key could be inserted,
+ * so that v[base + k - 1] < key <= v[base + k].
+ */
+template <typename Array, typename Comparator>
+int gallopLeft( const typename Array::value_type & key, const Array & v, int base, int length, int hint,
+                Comparator less_than ) {
+    int lastOffset = 0, offset = 1;
+    if( less_than( v[ base + hint ], key ) ) {
+        // Gallop right until v[base + hint + lastOffset] < key <= v[base + hint + offset]
+        int maxOffset = length - hint;
+        while( offset < maxOffset && less_than( v[ base + hint + offset ], key ) ) {
+            lastOffset = offset;
+            offset = ( offset << 1 ) + 1;
+            if( offset <= 0 )
+                offset = maxOffset;
+        }
+        offset = min( offset, maxOffset );
+        lastOffset += hint;
+        offset += hint;
+    }
+    else {
+        // Gallop left until v[base + hint - offset] < key <= v[base + hint - lastOffset]
+        int maxOffset = hint + 1;
+        while( offset < maxOffset && !less_than( v[ base + hint - offset ], key ) ) {
+            lastOffset = offset;
+            offset = ( offset << 1 ) + 1;
+            if( offset <= 0 )
+                offset = maxOffset;
+        }
+        offset = min( offset, maxOffset );
+        int tmp = lastOffset;
+        lastOffset = hint - offset;
+        offset = hint - tmp;
+    }
+
+    // Binary search in v[base + lastOffset + 1 .. base + offset]
+    ++lastOffset;
+    while( lastOffset < offset ) {
+        int middle = lastOffset + ( offset - lastOffset ) / 2;
+        if( less_than( v[ base + middle ], key ) )
+            lastOffset = middle + 1;
+        else
+            offset = middle;
+    }
+    return offset;
+}
+
+/**
+ * Internal method for timSort.
+ * Like gallopLeft, but returns the rightmost insertion position k,
+ * so that v[base + k - 1] <= key < v[base + k].
+ */
+template <typename Array, typename Comparator>
+int gallopRight( const typename Array::value_type & key, const Array & v, int base, int length, int hint,
+                 Comparator less_than ) {
+    int lastOffset = 0, offset = 1;
+    if( less_than( key, v[ base + hint ] ) ) {
+        // Gallop left until v[base + hint - offset] <= key < v[base + hint - lastOffset]
+        int maxOffset = hint + 1;
+        while( offset < maxOffset && less_than( key, v[ base + hint - offset ] ) ) {
+            lastOffset = offset;
+            offset = ( offset << 1 ) + 1;
+            if( offset <= 0 )
+                offset = maxOffset;
+        }
+        offset = min( offset, maxOffset );
+        int tmp = lastOffset;
+        lastOffset = hint - offset;
+        offset = hint - tmp;
+    }
+    else {
+        // Gallop right until v[base + hint + lastOffset] <= key < v[base + hint + offset]
+        int maxOffset = length - hint;
+        while( offset < maxOffset && !less_than( key, v[ base + hint + offset ] ) ) {
+            lastOffset = offset;
+            offset = ( offset << 1 ) + 1;
+            if( offset <= 0 )
+                offset = maxOffset;
+        }
+        offset = min( offset, maxOffset );
+        lastOffset += hint;
+        offset += hint;
+    }
+
+    // Binary search in v[base + lastOffset + 1 .. base + offset]
+    ++lastOffset;
+    while( lastOffset < offset ) {
+        int middle = lastOffset + ( offset - lastOffset ) / 2;
+        if( less_than( key, v[ base + middle ] ) )
+            offset = middle;
+        else
+            lastOffset = middle + 1;
+    }
+    return offset;
+}
+
+/**
+ * Internal method for timSort that merges the adjacent runs
+ * a[base1..base1 + length1 - 1] and a[base2..base2 + length2 - 1],
+ * where length1 <= length2. The first run is moved to the merge buffer
+ * and the result is written from the left. Requires that the first
+ * item of the second run belongs before the first run's first item and
+ * the last item of the first run after the second run's last item,
+ * which mergeAt ensures.
+ */
+template <typename Array, typename Comparator>
+void mergeLow( Array & a, int base1, int length1, int base2, int length2,
+               TimSortState<typename Array::value_type> & state, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    vector<Comparable> & tmpArray = state.tmpArray;
+    if( static_cast<int>( tmpArray.size( ) ) < length1 )
+        tmpArray.resize( length1 );
+    std::move( a.begin( ) + base1, a.begin( ) + base1 + length1, tmpArray.begin( ) );
+
+    int cursor1 = 0, cursor2 = base2, dest = base1;
+    int minGallop = state.minGallop;
+    a[ dest++ ] = std::move( a[ cursor2++ ] );
+    if( --length2 == 0 )
+        goto done;
+    if( length1 == 1 )
+        goto done;
+
+    for( ; ; ) {
+        int count1 = 0, count2 = 0;    // Number of times in a row each run won
+
+        // Merge one item at a time until one run starts winning consistently
+        do {
+            if( less_than( a[ cursor2 ], tmpArray[ cursor1 ] ) ) {
+                a[ dest++ ] = std::move( a[ cursor2++ ] );
+                ++count2;
+                count1 = 0;
+                if( --length2 == 0 )
+                    goto done;
+            }
+            else {
+                a[ dest++ ] = std::move( tmpArray[ cursor1++ ] );
+                ++count1;
+                count2 = 0;
+                if( --length1 == 1 )
+                    goto done;
+            }
+        } while( ( count1 | count2 ) < minGallop );
+
+        // Gallop while either run keeps winning by long stretches
+        do {
+            count1 = gallopRight( a[ cursor2 ], tmpArray, cursor1, length1, 0, less_than );
+            if( count1 != 0 ) {
+                std::move( tmpArray.begin( ) + cursor1, tmpArray.begin( ) + cursor1 + count1, a.begin( ) + dest );
+                dest += count1;
+                cursor1 += count1;
+                length1 -= count1;
+                if( length1 <= 1 )
+                    goto done;
+            }
+            a[ dest++ ] = std::move( a[ cursor2++ ] );
+            if( --length2 == 0 )
+                goto done;
+
+            count2 = gallopLeft( tmpArray[ cursor1 ], a, cursor2, length2, 0, less_than );
+            if( count2 != 0 ) {
+                std::move( a.begin( ) + cursor2, a.begin( ) + cursor2 + count2, a.begin( ) + dest );
+                dest += count2;
+                cursor2 += count2;
+                length2 -= count2;
+                if( length2 == 0 )
+                    goto done;
+            }
+            a[ dest++ ] = std::move( tmpArray[ cursor1++ ] );
+            if( --length1 == 1 )
+                goto done;
+            --minGallop;
+        } while( count1 >= kTimSortMinGallop || count2 >= kTimSortMinGallop );
+
+        if( minGallop < 0 )
+            minGallop = 0;
+        minGallop += 2;    // Penalize leaving galloping mode
+    }
+
+done:
+    state.minGallop = max( minGallop, 1 );
+    if( length1 == 1 && length2 > 0 ) {
+        // The last item of the first run goes after all of the second
+        std::move( a.begin( ) + cursor2, a.begin( ) + cursor2 + length2, a.begin( ) + dest );
+        a[ dest + length2 ] = std::move( tmpArray[ cursor1 ] );
+    }
+    else
+        std::move( tmpArray.begin( ) + cursor1, tmpArray.begin( ) + cursor1 + length1, a.begin( ) + dest );
+}
+
+/**
+ * Internal method for timSort that merges the adjacent runs
+ * a[base1..base1 + length1 - 1] and a[base2..base2 + length2 - 1],
+ * where length1 >= length2. The mirror image of mergeLow: the second
+ * run is moved to the merge buffer and the result is written from the right.
+ */
+template <typename Array, typename Comparator>
+void mergeHigh( Array & a, int base1, int length1, int base2, int length2,
+                TimSortState<typename Array::value_type> & state, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    vector<Comparable> & tmpArray = state.tmpArray;
+    if( static_cast<int>( tmpArray.size( ) ) < length2 )
+        tmpArray.resize( length2 );
+    std::move( a.begin( ) + base2, a.begin( ) + base2 + length2, tmpArray.begin( ) );
+
+    int cursor1 = base1 + length1 - 1, cursor2 = length2 - 1, dest = base2 + length2 - 1;
+    int minGallop = state.minGallop;
+    a[ dest-- ] = std::move( a[ cursor1-- ] );
+    if( --length1 == 0 )
+        goto done;
+    if( length2 == 1 )
+        goto done;
+
+    for( ; ; ) {
+        int count1 = 0, count2 = 0;    // Number of times in a row each run won
+
+        // Merge one item at a time until one run starts winning consistently
+        do {
+            if( less_than( tmpArray[ cursor2 ], a[ cursor1 ] ) ) {
+                a[ dest-- ] = std::move( a[ cursor1-- ] );
+                ++count1;
+                count2 = 0;
+                if( --length1 == 0 )
+                    goto done;
+            }
+            else {
+                a[ dest-- ] = std::move( tmpArray[ cursor2-- ] );
+                ++count2;
+                count1 = 0;
+                if( --length2 == 1 )
+                    goto done;
+            }
+        } while( ( count1 | count2 ) < minGallop );
+
+        // Gallop while either run keeps winning by long stretches
+        do {
+            count1 = length1 - gallopRight( tmpArray[ cursor2 ], a, base1, length1, length1 - 1, less_than );
+            if( count1 != 0 ) {
+                dest -= count1;
+                cursor1 -= count1;
+                length1 -= count1;
+                std::move_backward( a.begin( ) + cursor1 + 1, a.begin( ) + cursor1 + 1 + count1,
+                                    a.begin( ) + dest + 1 + count1 );
+                if( length1 == 0 )
+                    goto done;
+            }
+            a[ dest-- ] = std::move( tmpArray[ cursor2-- ] );
+            if( --length2 == 1 )
+                goto done;
+
+            count2 = length2 - gallopLeft( a[ cursor1 ], tmpArray, 0, length2, length2 - 1, less_than );
+            if( count2 != 0 ) {
+                dest -= count2;
+                cursor2 -= count2;
+                length2 -= count2;
+                std::move( tmpArray.begin( ) + cursor2 + 1, tmpArray.begin( ) + cursor2 + 1 + count2,
+                           a.begin( ) + dest + 1 );
+                if( length2 <= 1 )
+                    goto done;
+            }
+            a[ dest-- ] = std::move( a[ cursor1-- ] );
+            if( --length1 == 0 )
+                goto done;
+            --minGallop;
+        } while( count1 >= kTimSortMinGallop || count2 >= kTimSortMinGallop );
+
+        if( minGallop < 0 )
+            minGallop = 0;
+        minGallop += 2;    // Penalize leaving galloping mode
+    }
+
+done:
+    state.minGallop = max( minGallop, 1 );
+    if( length2 == 1 && length1 > 0 ) {
+        // The first item of the second run goes before all of the first
+        dest -= length1;
+        cursor1 -= length1;
+        std::move_backward( a.begin( ) + cursor1 + 1, a.begin( ) + cursor1 + 1 + length1,
+                            a.begin( ) + dest + 1 + length1 );
+        a[ dest ] = std::move( tmpArray[ cursor2 ] );
+    }
+    else
+        std::move( tmpArray.begin( ), tmpArray.begin( ) + length2, a.begin( ) + dest - length2 + 1 );
+}
+
+/**
+ * Internal method for timSort that merges runs i and i + 1 of the run
+ * stack. Items of the first run that already precede the whole second
+ * run, and items of the second run that already follow the whole first
+ * run, are skipped by galloping; the rest is merged through a buffer
+ * the size of the smaller of the two remainders.
+ */
+template <typename Array, typename Comparator>
+void mergeAt( Array & a, TimSortState<typename Array::value_type> & state, int i, Comparator less_than ) {
+    int base1 = state.runBase[ i ], length1 = state.runLength[ i ];
+    int base2 = state.runBase[ i + 1 ], length2 = state.runLength[ i + 1 ];
+
+    state.runLength[ i ] = length1 + length2;
+    state.runBase.erase( state.runBase.begin( ) + i + 1 );
+    state.runLength.erase( state.runLength.begin( ) + i + 1 );
+
+    int skip = gallopRight( a[ base2 ], a, base1, length1, 0, less_than );
+    base1 += skip;
+    length1 -= skip;
+    if( length1 == 0 )
+        return;
+
+    length2 = gallopLeft( a[ base1 + length1 - 1 ], a, base2, length2, length2 - 1, less_than );
+    if( length2 == 0 )
+        return;
+
+    if( length1 <= length2 )
+        mergeLow( a, base1, length1, base2, length2, state, less_than );
+    else
+        mergeHigh( a, base1, length1, base2, length2, state, less_than );
+}
+
+/**
+ * Internal method for timSort that merges runs on top of the stack
+ * until, from the bottom up, every run is longer than the next one and
+ * than the two after it combined. This keeps the stack O(log n) deep
+ * and the merges balanced.
+ */
+template <typename Array, typename Comparator>
+void mergeCollapse( Array & a, TimSortState<typename Array::value_type> & state, Comparator less_than ) {
+    const vector<int> & length = state.runLength;
+    while( length.size( ) > 1 ) {
+        int n = length.size( ) - 2;
+        if( ( n > 0 && length[ n - 1 ] <= length[ n ] + length[ n + 1 ] ) ||
+            ( n > 1 && length[ n - 2 ] <= length[ n - 1 ] + length[ n ] ) ) {
+            if( length[ n - 1 ] < length[ n + 1 ] )
+                --n;
+        }
+        else if( length[ n ] > length[ n + 1 ] )
+            break;
+        mergeAt( a, state, n, less_than );
+    }
+}
+
+/**
+ * TimSort: adaptive, stable natural mergesort (driver).
+ * Ascending and strictly descending runs are found and the latter
+ * reversed; runs shorter than timSortMinRun are extended by insertion
+ * sort. Runs are pushed on a stack and merged by mergeCollapse, with
+ * galloping when one run wins repeatedly. Sorted and reverse sorted
+ * input take O(n) time. The merge buffer never grows past the shorter
+ * of the two runs being merged.
+ */
+template <typename Array, typename Comparator>
+void timSort( Array & a, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    int n = a.size( );
+    if( n < 2 )
+        return;
+
+    TimSortState<Comparable> state;
+    int minRun = timSortMinRun( n );
+    for( int left = 0; left < n; ) {
+        int length = countRunAndMakeAscending( a, left, n - 1, less_than );
+        if( length < minRun ) {
+            int forced = min( minRun, n - left );
+            insertionSort( a, left, left + forced - 1, less_than );
+            length = forced;
+        }
+
+        state.runBase.push_back( left );
+        state.runLength.push_back( length );
+        mergeCollapse( a, state, less_than );
+        left += length;
+    }
+
+    // Merge the remaining runs, smaller neighbours first
+    while( state.runLength.size( ) > 1 ) {
+        int i = state.runLength.size( ) - 2;
+        if( i > 0 && state.runLength[ i - 1 ] < state.runLength[ i + 1 ] )
+            --i;
+        mergeAt( a, state, i, less_than );
+    }
+}
+
+/**
+ * Internal method for InsertSorted.
+ * a[0..n-1] and batch are sorted, and a has room for batch after
+ * a[n-1]. Merges batch in from the back: for each batch item, from the
+ * last, gallopRight finds the run of a's items that belong after it,
+ * which is moved up in one block. Items of a that belong before the
+ * whole batch are not touched, and items of a come before equal items
+ * of batch.
+ */
+template <typename Array, typename Buffer, typename Comparator>
+void mergeBackward( Array & a, int n, Buffer & batch, Comparator less_than ) {
+    int i = n - 1, k = n + batch.size( ) - 1;
+    for( int j = batch.size( ) - 1; j >= 0; --j ) {
+        if( i >= 0 ) {
+            int keep = gallopRight( batch[ j ], a, 0, i + 1, i, less_than );
+            std::move_backward( a.begin( ) + keep, a.begin( ) + i + 1, a.begin( ) + k + 1 );
+            k -= i + 1 - keep;
+            i = keep - 1;
+        }
+        a[ k-- ] = std::move( batch[ j ] );
+    }
+}
+
+/**
+ * Return median of left, center, and right.
+ * Order these and hide the pivot.
+ */
+template <typename Array, typename Comparator>
+const typename Array::value_type & median3( Array & a, int left, int right, Comparator less_than ) {
+    int center = ( left + right ) / 2;
+
+    if( less_than(a[ center ], a[ left ]))
+        std::swap( a[ left ], a[ center ] );
+    if( less_than(a[ right ], a[ left ]))
+        std::swap( a[ left ], a[ right ] );
+    if( less_than(a[ right ], a[ center ]))
+        std::swap( a[ center ], a[ right ] );
+
+    // Place pivot at position right - 1
+    std::swap( a[ center ], a[ right - 1 ] );
+    return a[ right - 1 ];
+}
+
+/**
+ * Internal method that partitions a[left..right] for quicksort and
+ * introselect around the median-of-three pivot, with simdPartition
+ * when it applies and the scalar loop otherwise.
+ * leftEqualsPivot is set if every item left of the pivot equals it.
+ * Requires left + 10 <= right.
+ * Returns the final index of the pivot.
+ */
+template <typename Array, typename Comparator>
+int quicksortPartition( Array & a, int left, int right, Comparator less_than, bool & leftEqualsPivot ) {
+    typedef typename Array::value_type Comparable;
+    const Comparable & pivot = median3( a, left, right, less_than );
+
+        // Begin partitioning
+    int i = left, j = right - 1;
+    leftEqualsPivot = false;
+    if( !simdPartition( a, left + 1, right - 2, pivot, less_than, i, leftEqualsPivot ) ) {
+        for( ; ; ) {
+            while(less_than(a[ ++i ],pivot)) { }
+            while(less_than(pivot, a[ --j ])) { }
+            if( i < j )
+                std::swap( a[ i ], a[ j ] );
+            else
+                break;
+        }
+    }
+
+    std::swap( a[ i ], a[ right - 1 ] );  // Restore pivot
+    return i;
+}
+
+/**
+ * Internal quicksort method that makes recursive calls.
+ * Uses median-of-three partitioning and a cutoff of 10, or 32 when
+ * leafSort can use a sorting network.
+ * a is an array of Comparable items.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ */
+template <typename Array, typename Comparator>
+void quicksort( Array & a, int left, int right, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    if( left + QuickSortCutoff<Comparable, Comparator>::value <= right ) {
+                // cout<<endl<<"quicksort1 left: "<<left;
+        bool leftEqualsPivot;
+        int i = quicksortPartition( a, left, right, less_than, leftEqualsPivot );
+
+        if( !leftEqualsPivot )
+            quicksort( a, left, i - 1, less_than );     // Sort small elements
+        quicksort( a, i + 1, right, less_than );    // Sort large elements
+    }
+    else  // Do an insertion sort on the subarray
+        leafSort( a, left, right, less_than );
+}
+
+template <typename Array, typename Comparator>
+void quicksort2( Array & a, int left, int right, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    if( left + QuickSortCutoff<Comparable, Comparator>::value <= right ) {
+      int middle = (left + right)/2;
+      swap(a[middle], a[right]);
+      middle = a[right];
+
+      const Comparable & pivot = middle;
+
+      // Begin partitioning
+      int i = left-1, j = right;
+      bool leftEqualsPivot = false;
+      if( !simdPartition( a, left, right - 1, a[ right ], less_than, i, leftEqualsPivot ) ) {
+          for( ; ; )
+          {
+              while(less_than(a[ ++i ],pivot)) { }
+              while(j > left && less_than(pivot, a[--j ])) { }
+              if( i < j ){
+                  std::swap( a[ i ], a[ j ] );
+              }
+              else
+                  break;
+          }
+      }
+
+      std::swap( a[ i], a[ right] );  // Restore pivot
+      if( !leftEqualsPivot )
+          quicksort2( a, left, i-1, less_than );     // Sort small elements
+      quicksort2( a, i + 1, right, less_than );    // Sort large elements
+
+    }
+    else  // Do an insertion sort on the subarray
+        leafSort( a, left, right, less_than );
+}
+
+template <typename Array, typename Comparator>
+void quicksort3( Array & a, int left, int right, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    if( left + QuickSortCutoff<Comparable, Comparator>::value <= right ) {
+      int first = left;
+      swap(a[first], a[right]);
+      first = a[right];
+
+      const Comparable & pivot = first;
+
+            // Begin partitioning
+        int i = left-1, j = right;
+        for( ; ; ) {
+            while(less_than(a[ ++i ],pivot)) { }
+            while(j > left && less_than(pivot, a[--j ])) { }
+            if( i < j ){
+                std::swap( a[ i ], a[ j ] );
+
+            }
+            else
+                break;
+        }
+
+        std::swap( a[ i ], a[ right] );  // Restore pivot
+        quicksort3( a, left, i - 1, less_than );     // Sort small elements
+        quicksort3( a, i + 1, right, less_than );    // Sort large elements
+    }
+    else  // Do an insertion sort on the subarray
+        leafSort( a, left, right, less_than );
+}
+
+/**
+ * Quicksort algorithm (driver).
+ */
+template <typename Array, typename Comparator>
+void quicksort( Array & a, Comparator less_than ) {
+    quicksort( a, 0, a.size( ) - 1, less_than);
+}
+
+/**
+ * Quicksort algorithm (driver).
+ */
+template <typename Array, typename Comparator>
+void quicksort2( Array & a, Comparator less_than ) {
+    quicksort2( a, 0, a.size( ) - 1, less_than);
+}
+
+/**
+ * Quicksort algorithm (driver).
+ */
+template <typename Array, typename Comparator>
+void quicksort3( Array & a, Comparator less_than ) {
+    quicksort3( a, 0, a.size( ) - 1, less_than);
+}
+
+/**
+ * Internal method that partitions a[left..right] around the
+ * median-of-three pivot with the scalar loop of quicksort.
+ * Requires left + 10 <= right.
+ * Returns the final index of the pivot.
+ */
+template <typename Array, typename Comparator>
+int medianOf3Partition( Array & a, int left, int right, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    const Comparable & pivot = median3( a, left, right, less_than );
+
+    int i = left, j = right - 1;
+    for( ; ; ) {
+        while(less_than(a[ ++i ],pivot)) { }
+        while(less_than(pivot, a[ --j ])) { }
+        if( i < j )
+            std::swap( a[ i ], a[ j ] );
+        else
+            break;
+    }
+
+    std::swap( a[ i ], a[ right - 1 ] );  // Restore pivot
+    return i;
+}
+
+/**
+ * Subarrays smaller than this are not split into new tasks by the
+ * parallel quicksort; the worker that holds one sorts it with quicksort.
+ */
+const int kParallelQuickSortCutoff = 1 << 12;
+
+/**
+ * Double-ended queue of subarrays owned by one parallel quicksort worker.
+ * The owner pushes and pops at the back, so it keeps working on the
+ * subarrays it split most recently. Idle workers steal from the front,
+ * where the oldest and largest subarrays are.
+ */
+class QuickSortTaskDeque {
+  public:
+    void push( int left, int right ) {
+        lock_guard<mutex> guard( lock );
+        tasks.push_back( make_pair( left, right ) );
+    }
+
+    bool pop( int & left, int & right ) {
+        lock_guard<mutex> guard( lock );
+        if( tasks.empty( ) )
+            return false;
+        left = tasks.back( ).first;
+        right = tasks.back( ).second;
+        tasks.pop_back( );
+        return true;
+    }
+
+    bool steal( int & left, int & right ) {
+        lock_guard<mutex> guard( lock );
+        if( tasks.empty( ) )
+            return false;
+        left = tasks.front( ).first;
+        right = tasks.front( ).second;
+        tasks.pop_front( );
+        return true;
+    }
+
+  private:
+    mutex lock;
+    deque<pair<int, int>> tasks;
+};
+
+/**
+ * Internal method run by each parallel quicksort worker.
+ * A task is partitioned repeatedly; the larger side is pushed to the
+ * worker's own deque, where others can steal it, and the smaller side
+ * is kept. This keeps all workers busy even when pivots are skewed.
+ * pending counts the tasks that have been pushed but not finished.
+ */
+template <typename Array, typename Comparator>
+void parallelQuicksortWorker( Array & a, Comparator less_than, vector<QuickSortTaskDeque> & deques,
+                              int self, atomic<int> & pending ) {
+    int numWorkers = deques.size( );
+    int left, right;
+
+    while( pending.load( ) > 0 ) {
+        if( !deques[ self ].pop( left, right ) ) {
+            bool stolen = false;
+            for( int k = 1; k < numWorkers && !stolen; ++k )
+                stolen = deques[ ( self + k ) % numWorkers ].steal( left, right );
+            if( !stolen ) {
+                this_thread::yield( );
+                continue;
+            }
+        }
+
+        while( left + kParallelQuickSortCutoff <= right ) {
+            int i = medianOf3Partition( a, left, right, less_than );
+            ++pending;
+            if( i - left < right - i ) {
+                deques[ self ].push( i + 1, right );
+                right = i - 1;
+            }
+            else {
+                deques[ self ].push( left, i - 1 );
+                left = i + 1;
+            }
+        }
+
+        quicksort( a, left, right, less_than );  // Falls back to insertionSort for tiny subarrays
+        --pending;
+    }
+}
+
+/**
+ * Parallel quicksort algorithm (driver).
+ * threads is the number of worker threads, each with its own deque.
+ */
+template <typename Array, typename Comparator>
+void parallelQuicksort( Array & a, Comparator less_than, int threads ) {
+    if( threads <= 1 || a.size( ) <= static_cast<size_t>( kParallelQuickSortCutoff ) ) {
+        quicksort( a, less_than );
+        return;
+    }
+
+    vector<QuickSortTaskDeque> deques( threads );
+    atomic<int> pending( 1 );
+    deques[ 0 ].push( 0, a.size( ) - 1 );
+
+    vector<thread> workers;
+    for( int t = 1; t < threads; ++t )
+        workers.push_back( thread( [&, t]( ) { parallelQuicksortWorker( a, less_than, deques, t, pending ); } ) );
+    parallelQuicksortWorker( a, less_than, deques, 0, pending );
+    for( auto & worker : workers )
+        worker.join( );
+}
+
+/**
+ * Pivot rules for introsort, matching quicksort, quicksort2 and quicksort3.
+ */
+enum class PivotRule { MedianOfThree, Middle, First };
+
+/**
+ * Internal method that partitions a[left..right] for introsort.
+ * The Middle and First rules move the pivot to a[right] like quicksort2
+ * and quicksort3, but the right-to-left scan stops at left so a pivot
+ * smaller than everything cannot run off the subarray.
+ * Requires left + 10 <= right.
+ * Returns the final index of the pivot.
+ */
+template <typename Array, typename Comparator>
+int introsortPartition( Array & a, int left, int right, PivotRule rule, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    if( rule == PivotRule::MedianOfThree )
+        return medianOf3Partition( a, left, right, less_than );
+
+    std::swap( a[ rule == PivotRule::Middle ? ( left + right ) / 2 : left ], a[ right ] );
+    const Comparable & pivot = a[ right ];
+
+    int i = left - 1, j = right;
+    for( ; ; ) {
+        while(less_than(a[ ++i ], pivot)) { }
+        while(j > left && less_than(pivot, a[ --j ])) { }
+        if( i < j )
+            std::swap( a[ i ], a[ j ] );
+        else
+            break;
+    }
+
+    std::swap( a[ i ], a[ right ] );  // Restore pivot
+    return i;
+}
+
+/**
+ * Internal introsort method.
+ * Partitions like quicksort until depthLimit partitioning levels have
+ * been used, then finishes the subarray with heapsort, so the running
+ * time is O(n log n) whatever the pivot rule. Only the smaller side is
+ * sorted recursively and the larger one is handled by the loop, which
+ * keeps the stack depth O(log n).
+ * a is an array of Comparable items.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ */
+template <typename Array, typename Comparator>
+void introsort( Array & a, int left, int right, int depthLimit, PivotRule rule, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    while( left + QuickSortCutoff<Comparable, Comparator>::value <= right ) {
+        if( depthLimit-- == 0 ) {
+            heapsort( a, left, right, less_than );
+            return;
+        }
+
+        int i = introsortPartition( a, left, right, rule, less_than );
+        if( i - left < right - i ) {
+            introsort( a, left, i - 1, depthLimit, rule, less_than );
+            left = i + 1;
+        }
+        else {
+            introsort( a, i + 1, right, depthLimit, rule, less_than );
+            right = i - 1;
+        }
+    }
+
+    leafSort( a, left, right, less_than );
+}
+
+/**
+ * Internal method for introsort and introselect.
+ * Returns the partitioning depth budget for n items.
+ */
+inline int introsortDepthLimit( size_t n ) {
+    int depthLimit = 0;
+    for( ; n > 1; n /= 2 )
+        depthLimit += 2;
+    return depthLimit;
+}
+
+/**
+ * Introsort algorithm (driver).
+ * The depth budget is 2 * floor(log2(n)) partitioning levels.
+ */
+template <typename Array, typename Comparator>
+void introsort( Array & a, PivotRule rule, Comparator less_than ) {
+    introsort( a, 0, a.size( ) - 1, introsortDepthLimit( a.size( ) ), rule, less_than );
+}
+
+/**
+ * Tuning constants for pdqsort.
+ * Subarrays smaller than kPdqInsertionSortCutoff go to insertionSort,
+ * larger than kPdqNintherCutoff use a pseudomedian of nine as pivot,
+ * partial insertion sorts give up after kPdqPartialInsertionLimit moves,
+ * and the branchless partition scans blocks of kPdqBlockSize items.
+ */
+const int kPdqInsertionSortCutoff = 24;
+const int kPdqNintherCutoff = 128;
+const int kPdqPartialInsertionLimit = 8;
+const int kPdqBlockSize = 64;
+
+/**
+ * Internal method for pdqsort that orders a[i], a[j] and a[k].
+ */
+template <typename Array, typename Comparator>
+void sort3( Array & a, int i, int j, int k, Comparator less_than ) {
+    if( less_than( a[ j ], a[ i ] ) )
+        std::swap( a[ i ], a[ j ] );
+    if( less_than( a[ k ], a[ j ] ) ) {
+        std::swap( a[ j ], a[ k ] );
+        if( less_than( a[ j ], a[ i ] ) )
+            std::swap( a[ i ], a[ j ] );
+    }
+}
+
+/**
+ * Internal method for pdqsort.
+ * Insertion sort on a[left..right] that gives up once more than
+ * kPdqPartialInsertionLimit items have been moved.
+ * Returns true if the subarray is now sorted.
+ */
+template <typename Array, typename Comparator>
+bool partialInsertionSort( Array & a, int left, int right, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    int moved = 0;
+    for( int p = left + 1; p <= right; ++p ) {
+        if( less_than( a[ p ], a[ p - 1 ] ) ) {
+            Comparable tmp = std::move( a[ p ] );
+            int j;
+
+            for( j = p; j > left && less_than( tmp, a[ j - 1 ] ); --j )
+                a[ j ] = std::move( a[ j - 1 ] );
+
+            a[ j ] = std::move( tmp );
+            moved += p - j;
+        }
+        if( moved > kPdqPartialInsertionLimit )
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Internal method for pdqsort that partitions a[left..right] around the
+ * pivot in a[left], placing items equal to the pivot on the left.
+ * Used when the pivot equals the item just before the subarray, so all
+ * items equal to it can be skipped at once.
+ * Returns the final index of the pivot.
+ */
+template <typename Array, typename Comparator>
+int pdqPartitionLeft( Array & a, int left, int right, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    Comparable pivot = std::move( a[ left ] );
+    int i = left, j = right + 1;
+
+    while( less_than( pivot, a[ --j ] ) ) { }
+    if( j == right )
+        while( i < j && !less_than( pivot, a[ ++i ] ) ) { }
+    else
+        while( !less_than( pivot, a[ ++i ] ) ) { }
+
+    while( i < j ) {
+        std::swap( a[ i ], a[ j ] );
+        while( less_than( pivot, a[ --j ] ) ) { }
+        while( !less_than( pivot, a[ ++i ] ) ) { }
+    }
+
+    a[ left ] = std::move( a[ j ] );
+    a[ j ] = std::move( pivot );
+    return j;
+}
+
+/**
+ * Internal method for pdqsort that partitions a[left..right] around the
+ * pivot in a[left], placing items equal to the pivot on the right.
+ * With Branchless set, the unknown middle is scanned in blocks: the
+ * offsets of misplaced items are recorded with comparison results used as
+ * array increments rather than branches, then swapped in a second loop.
+ * alreadyPartitioned is set if no items had to be swapped.
+ * Returns the final index of the pivot.
+ */
+template <bool Branchless, typename Array, typename Comparator>
+int pdqPartitionRight( Array & a, int left, int right, Comparator less_than, bool & alreadyPartitioned ) {
+    typedef typename Array::value_type Comparable;
+    Comparable pivot = std::move( a[ left ] );
+    int i = left, j = right + 1;
+
+    // The pivot is a median of several items, so the first scan stops.
+    while( less_than( a[ ++i ], pivot ) ) { }
+    if( i - 1 == left )
+        while( i < j && !less_than( a[ --j ], pivot ) ) { }
+    else
+        while( !less_than( a[ --j ], pivot ) ) { }
+
+    alreadyPartitioned = i >= j;
+
+    if( !Branchless ) {
+        while( i < j ) {
+            std::swap( a[ i ], a[ j ] );
+            while( less_than( a[ ++i ], pivot ) ) { }
+            while( !less_than( a[ --j ], pivot ) ) { }
+        }
+    }
+    else if( !alreadyPartitioned ) {
+        std::swap( a[ i ], a[ j ] );
+        ++i;
+
+        // From here on a[i..j-1] is unknown; items before i belong left
+        // of the pivot and items from j on belong right of it.
+        alignas( 64 ) unsigned char offsetsLeft[ kPdqBlockSize ];
+        alignas( 64 ) unsigned char offsetsRight[ kPdqBlockSize ];
+        int baseLeft = i, baseRight = j;
+        int numLeft = 0, numRight = 0, startLeft = 0, startRight = 0;
+
+        while( i < j ) {
+            int unknown = j - i;
+            int leftSplit = numLeft == 0 ? ( numRight == 0 ? unknown / 2 : unknown ) : 0;
+            int rightSplit = numRight == 0 ? unknown - leftSplit : 0;
+
+            // Record items on the wrong side without branching on the comparison.
+            int leftCount = min( leftSplit, kPdqBlockSize );
+            for( int k = 0; k < leftCount; ++k ) {
+                offsetsLeft[ numLeft ] = k;
+                numLeft += !less_than( a[ i++ ], pivot );
+            }
+            int rightCount = min( rightSplit, kPdqBlockSize );
+            for( int k = 1; k <= rightCount; ++k ) {
+                offsetsRight[ numRight ] = k;
+                numRight += less_than( a[ --j ], pivot );
+            }
+
+            // Swap pairs of misplaced items. With unequal counts the pairs
+            // are rotated through one temporary, which saves a move per pair.
+            int num = min( numLeft, numRight );
+            if( numLeft == numRight ) {
+                for( int k = 0; k < num; ++k )
+                    std::swap( a[ baseLeft + offsetsLeft[ startLeft + k ] ],
+                               a[ baseRight - offsetsRight[ startRight + k ] ] );
+            }
+            else if( num > 0 ) {
+                int l = baseLeft + offsetsLeft[ startLeft ];
+                int r = baseRight - offsetsRight[ startRight ];
+                Comparable tmp = std::move( a[ l ] );
+                a[ l ] = std::move( a[ r ] );
+                for( int k = 1; k < num; ++k ) {
+                    l = baseLeft + offsetsLeft[ startLeft + k ];
+                    a[ r ] = std::move( a[ l ] );
+                    r = baseRight - offsetsRight[ startRight + k ];
+                    a[ l ] = std::move( a[ r ] );
+                }
+                a[ r ] = std::move( tmp );
+            }
+
+            numLeft -= num;
+            numRight -= num;
+            startLeft += num;
+            startRight += num;
+            if( numLeft == 0 ) {
+                startLeft = 0;
+                baseLeft = i;
+            }
+            if( numRight == 0 ) {
+                startRight = 0;
+                baseRight = j;
+            }
+        }
+
+        // One side still has misplaced items; move them past the other.
+        if( numLeft > 0 ) {
+            while( numLeft-- > 0 )
+                std::swap( a[ baseLeft + offsetsLeft[ startLeft + numLeft ] ], a[ --j ] );
+            i = j;
+        }
+        if( numRight > 0 ) {
+            while( numRight-- > 0 )
+                std::swap( a[ baseRight - offsetsRight[ startRight + numRight ] ], a[ i++ ] );
+            j = i;
+        }
+    }
+
+    int pivotPos = i - 1;
+    a[ left ] = std::move( a[ pivotPos ] );
+    a[ pivotPos ] = std::move( pivot );
+    return pivotPos;
+}
+
+/**
+ * Internal pdqsort (pattern-defeating quicksort) method.
+ * Chooses the pivot with median3, or a pseudomedian of nine on large
+ * subarrays, and moves it to a[left]. Runs of items equal to an earlier
+ * pivot are split off with pdqPartitionLeft. Subarrays that were already
+ * partitioned are finished with partialInsertionSort when possible, so
+ * sorted input takes linear time. After a very unbalanced partition some
+ * items are swapped around to break up the pattern, and after
+ * badAllowed of them the subarray is finished with heapsort.
+ * leftmost tells whether a[left-1] may be used as a sentinel.
+ */
+template <bool Branchless, typename Array, typename Comparator>
+void pdqsort( Array & a, int left, int right, Comparator less_than, int badAllowed, bool leftmost ) {
+    for( ; ; ) {
+        int size = right - left + 1;
+        if( size < kPdqInsertionSortCutoff ) {
+            insertionSort( a, left, right, less_than );
+            return;
+        }
+
+        int half = size / 2;
+        if( size > kPdqNintherCutoff ) {
+            sort3( a, left, left + half, right, less_than );
+            sort3( a, left + 1, left + half - 1, right - 1, less_than );
+            sort3( a, left + 2, left + half + 1, right - 2, less_than );
+            sort3( a, left + half - 1, left + half, left + half + 1, less_than );
+            std::swap( a[ left ], a[ left + half ] );
+        }
+        else {
+            median3( a, left, right, less_than );
+            std::swap( a[ left ], a[ right - 1 ] );
+        }
+
+        // The pivot equals the previous pivot, so no item is smaller.
+        if( !leftmost && !less_than( a[ left - 1 ], a[ left ] ) ) {
+            left = pdqPartitionLeft( a, left, right, less_than ) + 1;
+            continue;
+        }
+
+        bool alreadyPartitioned;
+        int pivotPos = pdqPartitionRight<Branchless>( a, left, right, less_than, alreadyPartitioned );
+
+        int leftSize = pivotPos - left;
+        int rightSize = right - pivotPos;
+        if( leftSize < size / 8 || rightSize < size / 8 ) {
+            if( --badAllowed == 0 ) {
+                heapsort( a, left, right, less_than );
+                return;
+            }
+
+            if( leftSize >= kPdqInsertionSortCutoff ) {
+                std::swap( a[ left ], a[ left + leftSize / 4 ] );
+                std::swap( a[ pivotPos - 1 ], a[ pivotPos - leftSize / 4 ] );
+                if( leftSize > kPdqNintherCutoff ) {
+                    std::swap( a[ left + 1 ], a[ left + leftSize / 4 + 1 ] );
+                    std::swap( a[ left + 2 ], a[ left + leftSize / 4 + 2 ] );
+                    std::swap( a[ pivotPos - 2 ], a[ pivotPos - leftSize / 4 - 1 ] );
+                    std::swap( a[ pivotPos - 3 ], a[ pivotPos - leftSize / 4 - 2 ] );
+                }
+            }
+            if( rightSize >= kPdqInsertionSortCutoff ) {
+                std::swap( a[ pivotPos + 1 ], a[ pivotPos + rightSize / 4 + 1 ] );
+                std::swap( a[ right ], a[ right - rightSize / 4 + 1 ] );
+                if( rightSize > kPdqNintherCutoff ) {
+                    std::swap( a[ pivotPos + 2 ], a[ pivotPos + rightSize / 4 + 2 ] );
+                    std::swap( a[ pivotPos + 3 ], a[ pivotPos + rightSize / 4 + 3 ] );
+                    std::swap( a[ right - 1 ], a[ right - rightSize / 4 ] );
+                    std::swap( a[ right - 2 ], a[ right - rightSize / 4 - 1 ] );
+                }
+            }
+        }
+        else if( alreadyPartitioned && partialInsertionSort( a, left, pivotPos - 1, less_than )
+                 && partialInsertionSort( a, pivotPos + 1, right, less_than ) ) {
+            return;
+        }
+
+        pdqsort<Branchless>( a, left, pivotPos - 1, less_than, badAllowed, leftmost );
+        left = pivotPos + 1;
+        leftmost = false;
+    }
+}
+
+/**
+ * Pattern-defeating quicksort algorithm (driver).
+ * The branchless block partition is used for arithmetic types, where
+ * comparisons are cheap and their branches are hard to predict.
+ */
+template <typename Array, typename Comparator>
+void pdqsort( Array & a, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    int badAllowed = 0;
+    for( size_t n = a.size( ); n > 1; n /= 2 )
+        ++badAllowed;
+    pdqsort<is_arithmetic<Comparable>::value>( a, 0, a.size( ) - 1, less_than, badAllowed, true );
+}
+
+/**
+ * Internal method for three-way quicksort (Bentley and McIlroy).
+ * Partitions a[left..right] around the median of three, which is moved
+ * to a[left], into items smaller than, equal to and larger than it in a
+ * single pass. Items equal to the pivot are swapped to the two ends as
+ * the scans meet them and swapped into the middle at the end.
+ * Requires left < right.
+ * On return a[left..lastSmaller] are smaller than the pivot and
+ * a[firstLarger..right] larger; everything between equals it.
+ */
+template <typename Array, typename Comparator>
+void threeWayPartition( Array & a, int left, int right, Comparator less_than,
+                        int & lastSmaller, int & firstLarger ) {
+    typedef typename Array::value_type Comparable;
+    int middle = ( left + right ) / 2;
+    sort3( a, middle, left, right, less_than );
+    const Comparable & pivot = a[ left ];    // Stays put until the loop ends
+
+    // a[left..p] and a[q..right] hold items equal to the pivot
+    int i = left, j = right + 1, p = left, q = right + 1;
+    for( ; ; ) {
+        // a[right] >= pivot and a[left] == pivot stop the scans
+        while( less_than( a[ ++i ], pivot ) ) { }
+        while( less_than( pivot, a[ --j ] ) ) { }
+        if( i == j && !less_than( a[ i ], pivot ) && !less_than( pivot, a[ i ] ) )
+            std::swap( a[ ++p ], a[ i ] );
+        if( i >= j )
+            break;
+
+        std::swap( a[ i ], a[ j ] );
+        // Now a[i] <= pivot <= a[j], so one comparison tells each is equal
+        if( !less_than( a[ i ], pivot ) )
+            std::swap( a[ ++p ], a[ i ] );
+        if( !less_than( pivot, a[ j ] ) )
+            std::swap( a[ --q ], a[ j ] );
+    }
+
+    i = j + 1;
+    for( int k = left; k <= p; ++k )
+        std::swap( a[ k ], a[ j-- ] );
+    for( int k = right; k >= q; --k )
+        std::swap( a[ k ], a[ i++ ] );
+    lastSmaller = j;
+    firstLarger = i;
+}
+
+/**
+ * Internal three-way quicksort method.
+ * The range of items equal to the pivot is left out of both recursive
+ * calls, so an array with d distinct keys is sorted in O(n log d) time.
+ * Like introsort it recurses into the smaller side, loops on the larger
+ * one and falls back to heapsort after depthLimit levels.
+ */
+template <typename Array, typename Comparator>
+void quicksort3Way( Array & a, int left, int right, int depthLimit, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    while( left + QuickSortCutoff<Comparable, Comparator>::value <= right ) {
+        if( depthLimit-- == 0 ) {
+            heapsort( a, left, right, less_than );
+            return;
+        }
+
+        int lastSmaller, firstLarger;
+        threeWayPartition( a, left, right, less_than, lastSmaller, firstLarger );
+        if( lastSmaller - left < right - firstLarger ) {
+            quicksort3Way( a, left, lastSmaller, depthLimit, less_than );
+            left = firstLarger;
+        }
+        else {
+            quicksort3Way( a, firstLarger, right, depthLimit, less_than );
+            right = lastSmaller;
+        }
+    }
+
+    leafSort( a, left, right, less_than );
+}
+
+/**
+ * Three-way quicksort algorithm (driver).
+ */
+template <typename Array, typename Comparator>
+void quicksort3Way( Array & a, Comparator less_than ) {
+    quicksort3Way( a, 0, a.size( ) - 1, introsortDepthLimit( a.size( ) ), less_than );
+}
+
+/**
+ * Tells whether a vector of Comparable ordered by Comparator can be
+ * radix sorted instead of compared: the items must be integers and the
+ * comparator std::less or std::greater.
+ */
+template <typename Comparable, typename Comparator>
+struct RadixSortable : false_type { };
+
+template <typename Comparable>
+struct RadixSortable<Comparable, less<Comparable>>
+    : integral_constant<bool, is_integral<Comparable>::value && !is_same<Comparable, bool>::value> { };
+
+template <typename Comparable>
+struct RadixSortable<Comparable, greater<Comparable>>
+    : integral_constant<bool, is_integral<Comparable>::value && !is_same<Comparable, bool>::value> { };
+
+#if __cplusplus >= 201402L
+template <typename Comparable>
+struct RadixSortable<Comparable, less<>> : RadixSortable<Comparable, less<Comparable>> { };
+
+template <typename Comparable>
+struct RadixSortable<Comparable, greater<>> : RadixSortable<Comparable, greater<Comparable>> { };
+#endif
+
+/**
+ * Tells whether Comparator sorts from large to small.
+ */
+template <typename Comparator>
+struct RadixSortDescending : false_type { };
+
+template <typename Comparable>
+struct RadixSortDescending<greater<Comparable>> : true_type { };
+
+#if __cplusplus >= 201402L
+template <>
+struct RadixSortDescending<greater<>> : true_type { };
+#endif
+
+/**
+ * Vectors shorter than this are left to the comparison sorts even when
+ * they could be radix sorted, since the histograms would dominate.
+ */
+const size_t kRadixSortCutoff = 256;
+
+/**
+ * Internal method for radixSort.
+ * Maps x to an unsigned key whose natural order is the requested order
+ * of the items: the sign bit is flipped for signed types and all bits
+ * are flipped for descending order.
+ */
+template <typename Comparable>
+typename make_unsigned<Comparable>::type radixKey( Comparable x, bool descending ) {
+    typedef typename make_unsigned<Comparable>::type Key;
+    Key key = static_cast<Key>( x );
+    if( is_signed<Comparable>::value )
+        key ^= Key( 1 ) << ( 8 * sizeof( Key ) - 1 );
+    return descending ? static_cast<Key>( ~key ) : key;
+}
+
+/**
+ * LSD radix sort for integers, one byte per pass.
+ * The histograms for all bytes are counted in a single pass over a, and
+ * bytes on which all items agree are skipped. Passes alternate between
+ * a and one buffer of the same size, so at most one final copy is made.
+ * The sort is stable.
+ */
+template <typename Array>
+void radixSort( Array & a, bool descending ) {
+    typedef typename Array::value_type Comparable;
+    const int kBytes = sizeof( Comparable );
+    const size_t n = a.size( );
+    if( n < 2 )
+        return;
+
+    vector<size_t> counts( kBytes * 256, 0 );
+    for( size_t i = 0; i < n; ++i ) {
+        auto key = radixKey( a[ i ], descending );
+        for( int byte = 0; byte < kBytes; ++byte )
+            ++counts[ byte * 256 + ( ( key >> ( 8 * byte ) ) & 0xff ) ];
+    }
+
+    vector<Comparable> buffer( n );
+    Comparable *from = a.data( ), *to = buffer.data( );
+    for( int byte = 0; byte < kBytes; ++byte ) {
+        size_t *count = &counts[ byte * 256 ];
+        if( count[ ( radixKey( from[ 0 ], descending ) >> ( 8 * byte ) ) & 0xff ] == n )
+            continue;  // Every item has the same value in this byte
+
+        size_t offset = 0;
+        for( int digit = 0; digit < 256; ++digit ) {
+            size_t size = count[ digit ];
+            count[ digit ] = offset;
+            offset += size;
+        }
+
+        for( size_t i = 0; i < n; ++i )
+            to[ count[ ( radixKey( from[ i ], descending ) >> ( 8 * byte ) ) & 0xff ]++ ] = from[ i ];
+        std::swap( from, to );
+    }
+
+    if( from != a.data( ) )
+        std::copy( from, from + n, a.data( ) );
+}
+
+/**
+ * Internal method for countingSort.
+ * Inverse of radixKey: the item whose key is key.
+ */
+template <typename Comparable>
+Comparable radixItem( typename make_unsigned<Comparable>::type key, bool descending ) {
+    typedef typename make_unsigned<Comparable>::type Key;
+    if( descending )
+        key = static_cast<Key>( ~key );
+    if( is_signed<Comparable>::value )
+        key ^= Key( 1 ) << ( 8 * sizeof( Key ) - 1 );
+    return static_cast<Comparable>( key );
+}
+
+/**
+ * countingSort radix sorts items whose keys span this many values per
+ * item or more, as the counts would outgrow a radix sort's buffer.
+ */
+const size_t kCountingSortRange = 2;
+
+/**
+ * Counting sort for integers whose keys span fewer than kCountingSortRange
+ * values per item: one pass finds the smallest and largest key, one
+ * counts every key, and one writes the items back in order. Equal
+ * integers are identical, so no buffer of items is needed. Wider ranges
+ * are radix sorted instead.
+ */
+template <typename Array>
+void countingSort( Array & a, bool descending ) {
+    typedef typename Array::value_type Comparable;
+    const size_t n = a.size( );
+    if( n < 2 )
+        return;
+
+    auto low = radixKey( a[ 0 ], descending ), high = low;
+    for( size_t i = 1; i < n; ++i ) {
+        auto key = radixKey( a[ i ], descending );
+        low = min( low, key );
+        high = max( high, key );
+    }
+    if( uint64_t( high - low ) >= kCountingSortRange * n ) {
+        radixSort( a, descending );
+        return;
+    }
+
+    vector<size_t> counts( size_t( high - low ) + 1, 0 );
+    for( size_t i = 0; i < n; ++i )
+        ++counts[ radixKey( a[ i ], descending ) - low ];
+    size_t i = 0;
+    for( size_t key = 0; key < counts.size( ); ++key ) {
+        const Comparable x = radixItem<Comparable>( low + key, descending );
+        for( size_t k = counts[ key ]; k > 0; --k )
+            a[ i++ ] = x;
+    }
+}
+
+/**
+ * Tells whether the drivers may radix or counting sort an Array with
+ * Comparator: its items must be RadixSortable, and it must own them. A
+ * Span views memory that is sorted in place, such as a mapped file,
+ * where radix sort would need a buffer as large as the file.
+ */
+template <typename Array, typename Comparator>
+struct RadixSortableArray : RadixSortable<typename Array::value_type, Comparator> { };
+
+template <typename T, typename Comparator>
+struct RadixSortableArray<Span<T>, Comparator> : false_type { };
+
+/**
+ * Internal method used by the QuickSort and MergeSort drivers.
+ * Radix sorts a if RadixSortableArray allows it.
+ * Returns true if a was sorted.
+ */
+template <typename Array, typename Comparator>
+bool radixSortIfPossible( Array & a, Comparator, false_type ) {
+    return false;
+}
+
+template <typename Array, typename Comparator>
+bool radixSortIfPossible( Array & a, Comparator, true_type ) {
+    if( a.size( ) < kRadixSortCutoff )
+        return false;
+    radixSort( a, RadixSortDescending<Comparator>::value );
+    return true;
+}
+
+template <typename Array, typename Comparator>
+bool radixSortIfPossible( Array & a, Comparator less_than ) {
+    return radixSortIfPossible( a, less_than, RadixSortableArray<Array, Comparator>( ) );
+}
+
+/**
+ * Internal method used by the Sort driver.
+ * Counting sorts a if RadixSortableArray allows it.
+ * Returns true if a was sorted.
+ */
+template <typename Array, typename Comparator>
+bool countingSortIfPossible( Array & a, Comparator, false_type ) {
+    return false;
+}
+
+template <typename Array, typename Comparator>
+bool countingSortIfPossible( Array & a, Comparator, true_type ) {
+    countingSort( a, RadixSortDescending<Comparator>::value );
+    return true;
+}
+
+template <typename Array, typename Comparator>
+bool countingSortIfPossible( Array & a, Comparator less_than ) {
+    return countingSortIfPossible( a, less_than, RadixSortableArray<Array, Comparator>( ) );
+}
+
+/**
+ * Internal selection method that makes recursive calls.
+ * Uses median-of-three partitioning and a cutoff of 10.
+ * Places the kth smallest item in a[k-1].
+ * a is an array of Comparable items.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ * k is the desired rank (1 is minimum) in the entire array.
+ */
+template <typename Array, typename Comparator>
+void quickSelect( Array & a, int left, int right, int k, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    if (left + 10 <= right) {
+        const Comparable & pivot = median3( a, left, right, less_than );
+
+            // Begin partitioning
+        int i = left, j = right - 1;
+        for( ; ; )
+        {
+            while(less_than(a[ ++i ], pivot)) { }
+            while(less_than(pivot, a[ --j ])) { }
+            if( i < j )
+                std::swap( a[ i ], a[ j ] );
+            else
+                break;
+        }
+
+        std::swap( a[ i ], a[ right - 1 ] );  // Restore pivot
+
+            // Recurse; only this part changes
+        if( k <= i )
+            quickSelect( a, left, i - 1, k, less_than );
+        else if( k > i + 1 )
+            quickSelect( a, i + 1, right, k, less_than );
+    }
+    else  // Do an insertion sort on the subarray
         insertionSort( a, left, right, less_than );
 }
 
-template <typename Comparable, typename Comparator>
-void quicksort2( vector<Comparable> & a, int left, int right, Comparator less_than ) {
-    if( left + 10 <= right ) {
-      int middle = (left + right)/2;
-      swap(a[middle], a[right]);
-      middle = a[right];
+/**
+ * Quick selection algorithm.
+ * Places the kth smallest item in a[k-1].
+ * a is an array of Comparable items.
+ * k is the desired rank (1 is minimum) in the entire array.
+ */
+template <typename Array>
+void quickSelect( Array & a, int k ) {
+    typedef typename Array::value_type Comparable;
+    quickSelect( a, 0, a.size( ) - 1, k, less<Comparable>{ } );
+}
+
+/**
+ * Internal method for the selection routines.
+ * Partitions a[left..right] around the item at pivotIndex.
+ * Requires left + 10 <= right.
+ * Returns the final index of the pivot.
+ */
+template <typename Array, typename Comparator>
+int partitionAround( Array & a, int left, int right, int pivotIndex, Comparator less_than ) {
+    std::swap( a[ pivotIndex ], a[ left ] );
+    return introsortPartition( a, left, right, PivotRule::First, less_than );
+}
+
+template <typename Array, typename Comparator>
+void medianOfMediansSelect( Array & a, int left, int right, int k, Comparator less_than );
+
+/**
+ * Internal method for the selection routines.
+ * Returns the index of the median of the medians of groups of five in
+ * a[left..right], which has at least 30% of the items on either side.
+ * The group medians are gathered at the front of the subarray.
+ */
+template <typename Array, typename Comparator>
+int medianOfMedians( Array & a, int left, int right, Comparator less_than ) {
+    int medians = left;
+    for( int first = left; first <= right; first += 5 ) {
+        int last = min( first + 4, right );
+        insertionSort( a, first, last, less_than );
+        std::swap( a[ ( first + last ) / 2 ], a[ medians++ ] );
+    }
+
+    int middle = left + ( medians - 1 - left ) / 2;
+    medianOfMediansSelect( a, left, medians - 1, middle, less_than );
+    return middle;
+}
+
+/**
+ * Internal selection method with a worst case of O(n): every pivot is
+ * a median of medians.
+ * Places in a[k] the item that would be there if a[left..right] were
+ * sorted, with no greater item before it and no smaller item after it.
+ */
+template <typename Array, typename Comparator>
+void medianOfMediansSelect( Array & a, int left, int right, int k, Comparator less_than ) {
+    while( left + 10 <= right ) {
+        int i = partitionAround( a, left, right, medianOfMedians( a, left, right, less_than ), less_than );
+        if( k == i )
+            return;
+        if( k < i )
+            right = i - 1;
+        else
+            left = i + 1;
+    }
+    insertionSort( a, left, right, less_than );
+}
+
+/**
+ * Introselect (Musser).
+ * Narrows a[left..right] down to the side holding index k with the
+ * partitioning of quicksort, like quickSelect without recursion.
+ * After depthLimit partitioning levels it switches to
+ * medianOfMediansSelect, so the running time is O(n) in the worst case.
+ * Places in a[k] the item that would be there if a[left..right] were
+ * sorted, with no greater item before it and no smaller item after it.
+ */
+template <typename Array, typename Comparator>
+void introselect( Array & a, int left, int right, int k, int depthLimit, Comparator less_than ) {
+    while( left + 10 <= right ) {
+        if( depthLimit-- == 0 ) {
+            medianOfMediansSelect( a, left, right, k, less_than );
+            return;
+        }
+
+        bool leftEqualsPivot;
+        int i = quicksortPartition( a, left, right, less_than, leftEqualsPivot );
+        if( k == i || ( k < i && leftEqualsPivot ) )
+            return;
+        if( k < i )
+            right = i - 1;
+        else
+            left = i + 1;
+    }
+    insertionSort( a, left, right, less_than );
+}
+
+/**
+ * Introselect algorithm (driver).
+ * Places in a[k] the item that would be there if a were sorted.
+ */
+template <typename Array, typename Comparator>
+void introselect( Array & a, int k, Comparator less_than ) {
+    introselect( a, 0, a.size( ) - 1, k, introsortDepthLimit( a.size( ) ), less_than );
+}
+
+/**
+ * Internal class for SORT that releases the arena, uninitialized
+ * storage for size items, when SORT returns or throws.
+ */
+template <typename Comparable>
+struct ArenaDeleter {
+    size_t size;
+
+    void operator()( Comparable * arena ) const {
+        allocator<Comparable>( ).deallocate( arena, size );
+    }
+};
+
+/**
+ * Internal class for arenaSort: the items alive in the arena during
+ * one pass, in arena[sameBegin..sameEnd-1] and
+ * arena[largerBegin..largerEnd-1]. Whatever is left of them is
+ * destroyed with it, so no item stays behind in the arena if a
+ * comparison or a move throws.
+ */
+template <typename Comparable>
+struct ArenaItems {
+    Comparable * arena;
+    int sameBegin, sameEnd, largerBegin, largerEnd;
+
+    ~ArenaItems( ) {
+        for( int k = sameBegin; k < sameEnd; ++k )
+            arena[ k ].~Comparable( );
+        for( int k = largerBegin; k < largerEnd; ++k )
+            arena[ k ].~Comparable( );
+    }
+};
+
+/**
+ * Internal method for SORT that sorts items[low..high-1].
+ * Splits the range into the items smaller than, equal to and larger
+ * than its middle item in one pass: smaller ones are compacted in place
+ * at the front, equal ones are moved to arena[low..] and larger ones to
+ * arena[..high-1] from the back, and then both are moved back in
+ * order. arena is uninitialized storage: items are constructed in it
+ * and destroyed again when moved back, so its slots are empty between
+ * passes. Each range only uses the same slots of arena, so one arena of
+ * items.size( ) serves every level. Equal items keep their order, so
+ * the sort is stable. Short ranges go to insertionSort, and the larger
+ * side is handled by the loop to keep the stack depth O(log n).
+ */
+template <typename Comparable>
+void arenaSort( vector<Comparable> & items, Comparable * arena, int low, int high ) {
+    while( high - low > 10 ) {
+        const Comparable chosenItem = items[ low + ( high - low ) / 2 ];
+        ArenaItems<Comparable> alive = { arena, low, low, high, high };
+        int smaller = low;
+
+        for( int i = low; i < high; ++i ) {
+            if( items[ i ] < chosenItem ) {
+                if( smaller != i )
+                    items[ smaller ] = std::move( items[ i ] );
+                ++smaller;
+            }
+            else if( chosenItem < items[ i ] ) {
+                new( &arena[ alive.largerBegin - 1 ] ) Comparable( std::move( items[ i ] ) );
+                --alive.largerBegin;
+            }
+            else {
+                new( &arena[ alive.sameEnd ] ) Comparable( std::move( items[ i ] ) );
+                ++alive.sameEnd;
+            }
+        }
+
+        const int larger = alive.largerBegin;
+        for( int to = smaller; alive.sameBegin < alive.sameEnd; ++to ) {
+            items[ to ] = std::move( arena[ alive.sameBegin ] );
+            arena[ alive.sameBegin++ ].~Comparable( );
+        }
+        for( int to = larger; alive.largerBegin < alive.largerEnd; ++to ) {
+            items[ to ] = std::move( arena[ alive.largerEnd - 1 ] );
+            arena[ --alive.largerEnd ].~Comparable( );
+        }
+
+        // Smaller items are in items[low..smaller-1], larger in items[larger..high-1]
+        if( smaller - low < high - larger ) {
+            arenaSort( items, arena, low, smaller );
+            low = larger;
+        }
+        else {
+            arenaSort( items, arena, larger, high );
+            high = smaller;
+        }
+    }
+
+    insertionSort( items, low, high - 1, less<Comparable>{ } );
+}
+
+/**
+ * Three-bucket recursive sort: items smaller than, equal to and larger
+ * than the middle item, using operator<.
+ * Bucket storage comes from a single arena of items.size( ) items that
+ * every recursion level reuses, so there is one allocation per call and
+ * peak memory is about 2n. The arena is left uninitialized, so
+ * Comparable need not be default-constructible, and is released and
+ * emptied even if operator< or a move throws.
+ */
+template <typename Comparable>
+void SORT( vector<Comparable> & items )
+{
+    if( items.size( ) > 1 )
+    {
+        unique_ptr<Comparable, ArenaDeleter<Comparable>> arena( allocator<Comparable>( ).allocate( items.size( ) ),
+                                                                ArenaDeleter<Comparable>{ items.size( ) } );
+        arenaSort( items, arena.get( ), 0, items.size( ) );
+    }
+}
+
+/*
+ * This is the more public version of insertion sort.
+ * It requires a pair of iterators and a comparison
+ * function object.
+ */
+template <typename RandomIterator, typename Comparator>
+void insertionSort(const RandomIterator & begin, const RandomIterator & end, Comparator less_than) {
+    if( begin == end )
+        return;
+
+    RandomIterator j;
+
+    for( RandomIterator p = begin+1; p != end; ++p )
+    {
+        auto tmp = std::move( *p );
+        for( j = p; j != begin && less_than( tmp, *( j-1 ) ); --j )
+            *j = std::move( *(j-1) );
+        *j = std::move( tmp );
+    }
+}
+
+/*
+ * The two-parameter version calls the three parameter version, using C++11 decltype
+ */
+template <typename RandomIterator>
+void insertionSort(const RandomIterator & begin, const RandomIterator & end) {
+    insertionSort( begin, end, less<decltype(*begin )>{ } );
+}
+
+/**
+ * Tells whether a vector of String ordered by Comparator can be sorted
+ * byte by byte: String must be std::string or a vector of bytes, and the
+ * comparator std::less or std::greater.
+ */
+template <typename String, typename Comparator>
+struct StringSortable : false_type { };
+
+template <>
+struct StringSortable<string, less<string>> : true_type { };
+
+template <>
+struct StringSortable<string, greater<string>> : true_type { };
+
+template <>
+struct StringSortable<vector<unsigned char>, less<vector<unsigned char>>> : true_type { };
+
+template <>
+struct StringSortable<vector<unsigned char>, greater<vector<unsigned char>>> : true_type { };
+
+/**
+ * Ranges shorter than this are finished by insertionSort in the string sorts.
+ * MSD radix sort passes use 257 counters, which small ranges cannot pay for.
+ */
+const int kStringInsertionSortCutoff = 32;
+
+/**
+ * Internal method for the string sorts.
+ * Returns the byte of s at position depth plus one, or 0 if s is
+ * shorter, so that a string sorts before its extensions.
+ */
+template <typename String>
+inline int byteAt( const String & s, size_t depth ) {
+    return depth < s.size( ) ? static_cast<unsigned char>( s[ depth ] ) + 1 : 0;
+}
+
+/**
+ * Internal method for the string sorts.
+ * Compares two strings that share their first depth bytes.
+ */
+template <typename String>
+struct SuffixLess {
+    size_t depth;
+
+    bool operator()( const String & lhs, const String & rhs ) const {
+        for( size_t d = depth; ; ++d ) {
+            int l = byteAt( lhs, d ), r = byteAt( rhs, d );
+            if( l != r || l == 0 )
+                return l < r;
+        }
+    }
+};
 
-      const Comparable & pivot = middle;
+/**
+ * Internal method for the string sorts.
+ * Returns the length of the longest prefix shared by a[left..right],
+ * given that they share their first depth bytes.
+ * Makes a single pass over the range.
+ */
+template <typename String>
+size_t commonPrefixLength( const vector<String> & a, int left, int right, size_t depth ) {
+    size_t length = a[ left ].size( );
+    for( int i = left + 1; i <= right && length > depth; ++i ) {
+        size_t d = depth;
+        while( d < length && byteAt( a[ i ], d ) == byteAt( a[ left ], d ) )
+            ++d;
+        length = d;
+    }
+    return length;
+}
 
-      // Begin partitioning
-      int i = left-1, j = right;
-      for( ; ; )
-      {
-          while(less_than(a[ ++i ],pivot)) { }
-          while(less_than(pivot, a[--j ])) { }
-          if( i < j ){
-              std::swap( a[ i ], a[ j ] );
-          }
-          else
-              break;
-      }
+/**
+ * Internal multikey quicksort (Bentley and Sedgewick) method.
+ * Partitions a[left..right] three ways on the byte at depth, then sorts
+ * the smaller and larger parts at the same depth and the equal part at
+ * the next depth. Copes well with small or very skewed alphabets.
+ * All strings in a[left..right] share their first depth bytes.
+ */
+template <typename String>
+void multikeyQuicksort( vector<String> & a, int left, int right, size_t depth ) {
+    while( left + kStringInsertionSortCutoff <= right ) {
+        int low = byteAt( a[ left ], depth );
+        int mid = byteAt( a[ ( left + right ) / 2 ], depth );
+        int high = byteAt( a[ right ], depth );
+        int pivot = max( min( low, mid ), min( max( low, mid ), high ) );
+
+        // a[left..lt-1] < pivot, a[lt..i-1] == pivot, a[gt+1..right] > pivot
+        int lt = left, gt = right, i = left;
+        while( i <= gt ) {
+            int c = byteAt( a[ i ], depth );
+            if( c < pivot )
+                std::swap( a[ lt++ ], a[ i++ ] );
+            else if( c > pivot )
+                std::swap( a[ i ], a[ gt-- ] );
+            else
+                ++i;
+        }
 
-      std::swap( a[ i], a[ right] );  // Restore pivot
-      quicksort2( a, left, i-1, less_than );     // Sort small elements
-      quicksort2( a, i + 1, right, less_than );    // Sort large elements
+        multikeyQuicksort( a, left, lt - 1, depth );
+        multikeyQuicksort( a, gt + 1, right, depth );
+        if( pivot == 0 )
+            return;  // The equal part holds identical strings
 
+        // Skip the whole shared prefix at once rather than byte by byte.
+        depth = lt == left && gt == right ? commonPrefixLength( a, left, right, depth ) : depth + 1;
+        left = lt;
+        right = gt;
     }
-    else  // Do an insertion sort on the subarray
-        insertionSort( a, left, right, less_than );
+
+    insertionSort( a.begin( ) + left, a.begin( ) + ( right + 1 ), SuffixLess<String>{ depth } );
 }
 
-template <typename Comparable, typename Comparator>
-void quicksort3( vector<Comparable> & a, int left, int right, Comparator less_than ) {
-    if( left + 10 <= right ) {
-      int first = left;
-      swap(a[first], a[right]);
-      first = a[right];
+/**
+ * Internal American flag sort method (in-place MSD radix sort).
+ * Counts the byte at depth of every string in a[left..right], permutes
+ * the strings into their buckets in place by following cycles, then sorts
+ * each bucket at the next depth. When all strings share a byte, their
+ * whole common prefix is skipped in one pass without recursing. Ranges where one bucket holds most of
+ * the strings are handed to multikeyQuicksort, which wastes no passes
+ * on nearly empty buckets.
+ * All strings in a[left..right] share their first depth bytes.
+ */
+template <typename String>
+void americanFlagSort( vector<String> & a, int left, int right, size_t depth ) {
+    for( ; ; ) {
+        int n = right - left + 1;
+        if( n < kStringInsertionSortCutoff ) {
+            insertionSort( a.begin( ) + left, a.begin( ) + ( right + 1 ), SuffixLess<String>{ depth } );
+            return;
+        }
 
-      const Comparable & pivot = first;
+        int count[ 257 ] = { 0 };
+        for( int i = left; i <= right; ++i )
+            ++count[ byteAt( a[ i ], depth ) ];
 
-            // Begin partitioning
-        int i = left-1, j = right;
-        for( ; ; ) {
-            while(less_than(a[ ++i ],pivot)) { }
-            while(less_than(pivot, a[--j ])) { }
-            if( i < j ){
-                std::swap( a[ i ], a[ j ] );
+        int largest = *max_element( count, count + 257 );
+        if( largest == n ) {
+            if( count[ 0 ] == n )
+                return;  // All strings are identical
+            depth = commonPrefixLength( a, left, right, depth );
+            continue;
+        }
+        if( largest > n - n / 4 ) {
+            multikeyQuicksort( a, left, right, depth );
+            return;
+        }
+
+        int next[ 257 ], end[ 257 ];
+        for( int b = 0, start = left; b < 257; ++b ) {
+            next[ b ] = start;
+            start += count[ b ];
+            end[ b ] = start;
+        }
 
+        for( int b = 0; b < 257; ++b ) {
+            while( next[ b ] < end[ b ] ) {
+                int c = byteAt( a[ next[ b ] ], depth );
+                if( c == b )
+                    ++next[ b ];
+                else
+                    std::swap( a[ next[ b ] ], a[ next[ c ]++ ] );
             }
-            else
-                break;
         }
 
-        std::swap( a[ i ], a[ right] );  // Restore pivot
-        quicksort3( a, left, i - 1, less_than );     // Sort small elements
-        quicksort3( a, i + 1, right, less_than );    // Sort large elements
+        // Bucket 0 holds strings that have ended, which are all equal.
+        for( int b = 1, start = left + count[ 0 ]; b < 257; start += count[ b++ ] ) {
+            if( count[ b ] > 1 )
+                americanFlagSort( a, start, start + count[ b ] - 1, depth + 1 );
+        }
+        return;
     }
-    else  // Do an insertion sort on the subarray
-        insertionSort( a, left, right, less_than );
 }
 
 /**
- * Quicksort algorithm (driver).
+ * Comparator for the argsort drivers: orders indices into items by the
+ * items they refer to.
  */
-template <typename Comparable, typename Comparator>
-void quicksort( vector<Comparable> & a, Comparator less_than ) {
-    quicksort( a, 0, a.size( ) - 1, less_than);
-}
+template <typename Array, typename Comparator>
+struct IndexLess {
+    const Array * items;
+    Comparator less_than;
+
+    template <typename Index>
+    bool operator()( Index lhs, Index rhs ) const {
+        return less_than( ( *items )[ lhs ], ( *items )[ rhs ] );
+    }
+};
 
 /**
- * Quicksort algorithm (driver).
+ * Internal method for the argsort drivers.
+ * Returns the indices 0 .. size - 1 in order.
  */
-template <typename Comparable, typename Comparator>
-void quicksort2( vector<Comparable> & a, Comparator less_than ) {
-    quicksort2( a, 0, a.size( ) - 1, less_than);
+template <typename Index>
+vector<Index> identityPermutation( size_t size ) {
+    static_assert( is_integral<Index>::value, "permutations are arrays of integer indices" );
+    vector<Index> permutation( size );
+    for( size_t i = 0; i < size; ++i )
+        permutation[ i ] = static_cast<Index>( i );
+    return permutation;
 }
 
 /**
- * Quicksort algorithm (driver).
+ * Rearranges a so that a[ i ] becomes the item at the old a[ permutation[ i ] ],
+ * the order an argsort driver returns.
+ * Follows each cycle of the permutation once, so every item is moved
+ * once, plus one extra move per cycle, and n bits mark what is done.
  */
-template <typename Comparable, typename Comparator>
-void quicksort3( vector<Comparable> & a, Comparator less_than ) {
-    quicksort3( a, 0, a.size( ) - 1, less_than);
+template <typename Array, typename Index>
+void applyPermutation( Array & a, const vector<Index> & permutation ) {
+    typedef typename Array::value_type Comparable;
+    size_t n = a.size( );
+    vector<bool> placed( n, false );
+
+    for( size_t start = 0; start < n; ++start ) {
+        if( placed[ start ] )
+            continue;
+        placed[ start ] = true;
+        size_t from = permutation[ start ];
+        if( from == start )
+            continue;
+
+        Comparable tmp = std::move( a[ start ] );
+        size_t hole = start;
+        while( from != start ) {
+            a[ hole ] = std::move( a[ from ] );
+            placed[ from ] = true;
+            hole = from;
+            from = permutation[ hole ];
+        }
+        a[ hole ] = std::move( tmp );
+    }
 }
 
 /**
- * Internal selection method that makes recursive calls.
- * Uses median-of-three partitioning and a cutoff of 10.
- * Places the kth smallest item in a[k-1].
- * a is an array of Comparable items.
- * left is the left-most index of the subarray.
- * right is the right-most index of the subarray.
- * k is the desired rank (1 is minimum) in the entire array.
+ * Comparator for projection sorts: orders (key, index) pairs by key.
  */
-template <typename Comparable, typename Comparator>
-void quickSelect( vector<Comparable> & a, int left, int right, int k, Comparator less_than ) {
-    if (left + 10 <= right) {
-        const Comparable & pivot = median3( a, left, right );
+template <typename Comparator>
+struct ProjectedLess {
+    Comparator less_than;
 
-            // Begin partitioning
-        int i = left, j = right - 1;
-        for( ; ; )
-        {
-            while(less_than(a[ ++i ], pivot)) { }
-            while(less_than(pivot, a[ --j ])) { }
-            if( i < j )
-                std::swap( a[ i ], a[ j ] );
-            else
-                break;
-        }
+    template <typename Keyed>
+    bool operator()( const Keyed & lhs, const Keyed & rhs ) const {
+        return less_than( lhs.first, rhs.first );
+    }
+};
 
-        std::swap( a[ i ], a[ right - 1 ] );  // Restore pivot
+/**
+ * Internal methods for the projection MergeSort.
+ * Compute key_fn once per item, stably sort the items' indices by key,
+ * and then move each item of a once with applyPermutation.
+ * In general the (key, index) pairs, which are small and sit next to
+ * each other, are merge sorted. Integer keys of up to 32 bits under
+ * less<> or greater<> are instead packed with their index into one
+ * 64-bit integer and radix sorted; the index in the low half keeps
+ * equal keys in order.
+ */
+template <typename Array, typename KeyFunction, typename Comparator>
+void projectionMergeSort( Array & a, KeyFunction key_fn, Comparator less_than, false_type ) {
+    typedef typename Array::value_type Comparable;
+    typedef typename decay<decltype( key_fn( declval<const Comparable &>( ) ) )>::type Key;
+    typedef pair<Key, uint32_t> Keyed;
+
+    vector<Keyed> keyed;
+    keyed.reserve( a.size( ) );
+    for( size_t i = 0; i < a.size( ); ++i )
+        keyed.emplace_back( key_fn( a[ i ] ), static_cast<uint32_t>( i ) );
+    mergeSortBottomUp( keyed, ProjectedLess<Comparator>{ less_than } );
+
+    vector<uint32_t> permutation( keyed.size( ) );
+    for( size_t i = 0; i < keyed.size( ); ++i )
+        permutation[ i ] = keyed[ i ].second;
+    applyPermutation( a, permutation );
+}
 
-            // Recurse; only this part changes
-        if( k <= i )
-            quickSelect( a, left, i - 1, k );
-        else if( k > i + 1 )
-            quickSelect( a, i + 1, right, k );
+template <typename Array, typename KeyFunction, typename Comparator>
+void projectionMergeSort( Array & a, KeyFunction key_fn, Comparator less_than, true_type ) {
+    if( a.size( ) < kRadixSortCutoff ) {
+        projectionMergeSort( a, key_fn, less_than, false_type( ) );
+        return;
     }
-    else  // Do an insertion sort on the subarray
-        insertionSort( a, left, right, less_than );
+
+    vector<uint64_t> packed( a.size( ) );
+    for( size_t i = 0; i < a.size( ); ++i )
+        packed[ i ] = uint64_t( radixKey( key_fn( a[ i ] ), RadixSortDescending<Comparator>::value ) ) << 32 | i;
+    radixSort( packed, false );
+
+    vector<uint32_t> permutation( packed.size( ) );
+    for( size_t i = 0; i < packed.size( ); ++i )
+        permutation[ i ] = static_cast<uint32_t>( packed[ i ] );
+    applyPermutation( a, permutation );
+}
+
+template <typename Array, typename KeyFunction, typename Comparator>
+void projectionMergeSort( Array & a, KeyFunction key_fn, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    typedef typename decay<decltype( key_fn( declval<const Comparable &>( ) ) )>::type Key;
+    projectionMergeSort( a, key_fn, less_than,
+                         integral_constant<bool, RadixSortable<Key, Comparator>::value && sizeof( Key ) <= 4>( ) );
 }
 
 /**
- * Quick selection algorithm.
- * Places the kth smallest item in a[k-1].
- * a is an array of Comparable items.
- * k is the desired rank (1 is minimum) in the entire array.
+ * Engines the adaptive Sort driver chooses between.
  */
-template <typename Comparable>
-void quickSelect( vector<Comparable> & a, int k ) {
-    quickSelect( a, 0, a.size( ) - 1, k );
+enum class SortEngine { Insertion, TimSort, Counting, Radix, PdqSort };
+
+inline const char * sortEngineName( SortEngine engine ) {
+    switch( engine ) {
+      case SortEngine::Insertion: return "insertion sort";
+      case SortEngine::TimSort: return "TimSort";
+      case SortEngine::Counting: return "counting sort";
+      case SortEngine::Radix: return "RadixSort";
+      default: return "PdqSort";
+    }
 }
 
+/**
+ * What the Sort driver learns about its input from a sample: up to
+ * kSortProfileBlocks evenly spaced blocks of kSortProfileBlockLength
+ * adjacent items for the order, and up to kSortProfileKeys evenly spaced
+ * items for the number of distinct keys and the key range. Small inputs
+ * are sampled at no more than one item in kSortProfileFraction.
+ */
+const int kSortProfileBlocks = 32;
+const int kSortProfileBlockLength = 32;
+const int kSortProfileKeys = 128;
+const int kSortProfileFraction = 8;
 
-template <typename Comparable>
-void SORT( vector<Comparable> & items )
-{
-    if( items.size( ) > 1 )
-    {
-        vector<Comparable> smaller;
-        vector<Comparable> same;
-        vector<Comparable> larger;
+/**
+ * Inputs this short are insertion sorted without being sampled.
+ */
+const size_t kSortSmall = 32;
+
+struct SortProfile {
+    size_t size;
+    size_t pairs;          // Adjacent pairs compared
+    size_t ascents;        // Of those, pairs strictly in order
+    size_t descents;       // Of those, pairs out of order
+    size_t turns;          // Of those, pairs going the other way from the last unequal pair
+    size_t keys;           // Items sampled for the keys
+    size_t distinct;       // Distinct keys among them
+    bool radixSortable;
+    uint64_t keyRange;     // Largest minus smallest radix key, if radixSortable
+
+    /**
+     * Estimated number of runs in the whole input, ascending or
+     * descending, as TimSort finds them: a run ends where the order
+     * turns.
+     */
+    size_t runs( ) const {
+        return pairs == 0 ? 1 : 1 + size_t( double( turns ) / pairs * ( size - 1 ) );
+    }
+};
 
-        auto chosenItem = items[ items.size( ) / 2 ];
+/**
+ * Internal method for profileSort.
+ * Returns the largest minus the smallest radix key of the sampled items,
+ * or 0 when the items cannot be radix sorted.
+ */
+template <typename Array, typename Comparator>
+uint64_t sampledKeyRange( const Array & a, size_t step, Comparator, false_type ) {
+    return 0;
+}
 
-        for( auto & i : items )
-        {
-            if( i < chosenItem )
-                smaller.push_back( std::move( i ) );
-            else if( chosenItem < i )
-                larger.push_back( std::move( i ) );
-            else
-                same.push_back( std::move( i ) );
-        }
+template <typename Array, typename Comparator>
+uint64_t sampledKeyRange( const Array & a, size_t step, Comparator, true_type ) {
+    const bool descending = RadixSortDescending<Comparator>::value;
+    uint64_t low = radixKey( a[ 0 ], descending ), high = low;
+    for( size_t i = step; i < a.size( ); i += step ) {
+        uint64_t key = radixKey( a[ i ], descending );
+        low = min( low, key );
+        high = max( high, key );
+    }
+    return high - low;
+}
 
-        SORT( smaller );     // Recursive call!
-        SORT( larger );      // Recursive call!
+/**
+ * Internal method for the Sort driver.
+ * Samples a with at most kSortProfileBlocks * kSortProfileBlockLength * 2
+ * comparisons, and sorts a copy of at most kSortProfileKeys of its
+ * items, whatever its size. a.size( ) must be at least kSortSmall.
+ */
+template <typename Array, typename Comparator>
+SortProfile profileSort( const Array & a, Comparator less_than ) {
+    typedef typename Array::value_type Comparable;
+    typedef RadixSortableArray<Array, Comparator> Radix;
+    SortProfile profile = SortProfile( );
+    profile.size = a.size( );
+    profile.radixSortable = Radix::value;
+
+    const size_t blocks = max<size_t>( 1, min<size_t>( kSortProfileBlocks,
+                                       a.size( ) / ( kSortProfileBlockLength * kSortProfileFraction ) ) );
+    const size_t blockStep = a.size( ) / blocks;
+    for( size_t block = 0; block < blocks; ++block ) {
+        const size_t first = block * blockStep;
+        int direction = 0;    // Of the last unequal pair: 1 in order, -1 out of order
+        for( size_t i = first + 1; i < first + kSortProfileBlockLength; ++i ) {
+            ++profile.pairs;
+            int pair = less_than( a[ i ], a[ i - 1 ] ) ? -1 : less_than( a[ i - 1 ], a[ i ] ) ? 1 : 0;
+            if( pair == 0 )
+                continue;
+            ++( pair > 0 ? profile.ascents : profile.descents );
+            if( direction != 0 && pair != direction )
+                ++profile.turns;
+            direction = pair;
+        }
+    }
 
-        std::move( begin( smaller ), end( smaller ), begin( items ) );
-        std::move( begin( same ), end( same ), begin( items ) + smaller.size( ) );
-        std::move( begin( larger ), end( larger ), end( items ) - larger.size( ) );
+    const size_t keyStep = max<size_t>( kSortProfileFraction, a.size( ) / kSortProfileKeys );
+    vector<Comparable> keys;
+    keys.reserve( a.size( ) / keyStep + 1 );
+    for( size_t i = 0; i < a.size( ); i += keyStep )
+        keys.push_back( a[ i ] );
+    pdqsort( keys, less_than );
+    profile.keys = keys.size( );
+    profile.distinct = 1;
+    for( size_t i = 1; i < keys.size( ); ++i ) {
+        if( less_than( keys[ i - 1 ], keys[ i ] ) )
+            ++profile.distinct;
     }
+
+    profile.keyRange = sampledKeyRange( a, keyStep, less_than, Radix( ) );
+    return profile;
 }
 
-/*
- * This is the more public version of insertion sort.
- * It requires a pair of iterators and a comparison
- * function object.
+/**
+ * Inputs estimated to hold fewer than one run per this many items are
+ * left to TimSort.
  */
-template <typename RandomIterator, typename Comparator>
-void insertionSort(const RandomIterator & begin, const RandomIterator & end, Comparator less_than) {
-    if( begin == end )
-        return;
+const size_t kSortRunLength = 16;
 
-    RandomIterator j;
+/**
+ * Internal method for the Sort driver.
+ * Input estimated to hold fewer than one run per kSortRunLength items
+ * is made of a few long runs, which TimSort merges in O(n log runs)
+ * time, O(n) if sorted or reversed. Otherwise integers under less<> or
+ * greater<> whose sampled keys span fewer values than there are items
+ * are counting sorted in three passes; wider ranges are radix sorted, a
+ * pass per varying byte of key costing less than the log n levels of a
+ * comparison sort, unless there are few distinct keys: PdqSort
+ * partitions equal keys out in one pass and is then faster.
+ * Everything else goes to PdqSort. Three-way QuickSort is not among
+ * the engines, as PdqSort was faster on few distinct keys too, for ints
+ * and strings alike.
+ */
+inline SortEngine chooseSortEngine( const SortProfile & profile ) {
+    if( profile.size < kSortSmall )
+        return SortEngine::Insertion;
+    if( profile.runs( ) * kSortRunLength <= profile.size )
+        return SortEngine::TimSort;
+    if( profile.radixSortable && profile.keyRange < profile.size )
+        return SortEngine::Counting;
+    if( profile.radixSortable && profile.size >= kRadixSortCutoff && profile.distinct * 8 > profile.keys )
+        return SortEngine::Radix;
+    return SortEngine::PdqSort;
+}
 
-    for( RandomIterator p = begin+1; p != end; ++p )
-    {
-        auto tmp = std::move( *p );
-        for( j = p; j != begin && less_than( tmp, *( j-1 ) ); --j )
-            *j = std::move( *(j-1) );
-        *j = std::move( tmp );
+inline void logSortDecision( ostream & log, const SortProfile & profile, SortEngine engine ) {
+    log << "Sort: " << profile.size << " items";
+    if( profile.size >= kSortSmall ) {
+        log << ", " << profile.turns << " turns in " << profile.pairs << " sampled pairs (about "
+            << profile.runs( ) << " runs), " << profile.distinct << " distinct of " << profile.keys
+            << " sampled keys";
+        if( profile.radixSortable )
+            log << ", key range " << profile.keyRange;
     }
+    log << ": " << sortEngineName( engine ) << endl;
 }
 
-/*
- * The two-parameter version calls the three parameter version, using C++11 decltype
+/**
+ * SortFixed can run in constant expressions from C++17, where
+ * std::array can be modified in them.
  */
-template <typename RandomIterator>
-void insertionSort(const RandomIterator & begin, const RandomIterator & end) {
-    insertionSort( begin, end, less<decltype(*begin )>{ } );
+#if __cplusplus >= 201703L
+#define SORT_FIXED_CONSTEXPR constexpr
+#else
+#define SORT_FIXED_CONSTEXPR
+#endif
+
+/**
+ * Whether the compiler can reinterpret items as bits in constant
+ * expressions, as fixedSwapIf does to blend floating point items.
+ */
+#if defined( __has_builtin )
+#if __has_builtin( __builtin_bit_cast )
+#define SORT_FIXED_HAVE_BIT_CAST 1
+#endif
+#endif
+#ifndef SORT_FIXED_HAVE_BIT_CAST
+#define SORT_FIXED_HAVE_BIT_CAST 0
+#endif
+
+/**
+ * Tells whether fixedSwapIf blends items of type Comparable through a
+ * bit mask: floats and doubles, which GCC would otherwise branch on.
+ */
+template <typename Comparable>
+struct FixedBitBlend
+    : integral_constant<bool, SORT_FIXED_HAVE_BIT_CAST && is_floating_point<Comparable>::value &&
+                              ( sizeof( Comparable ) == 4 || sizeof( Comparable ) == 8 )> { };
+
+/**
+ * Internal methods for fixedCompareExchange.
+ * Exchanges a[I] and a[J] if swapped, writing both whatever swapped is:
+ * through a bit mask for FixedBitBlend items, with two selects on the
+ * same flag for the others.
+ */
+template <size_t I, size_t J, typename Comparable, size_t N>
+SORT_FIXED_CONSTEXPR void fixedSwapIf( array<Comparable, N> & a, bool swapped, true_type ) {
+#if SORT_FIXED_HAVE_BIT_CAST
+    typedef typename conditional<sizeof( Comparable ) == 8, uint64_t, uint32_t>::type Bits;
+    const Bits x = __builtin_bit_cast( Bits, a[ I ] ), y = __builtin_bit_cast( Bits, a[ J ] );
+    const Bits mask = Bits( 0 ) - Bits( swapped );
+    a[ I ] = __builtin_bit_cast( Comparable, Bits( ( x & ~mask ) | ( y & mask ) ) );
+    a[ J ] = __builtin_bit_cast( Comparable, Bits( ( y & ~mask ) | ( x & mask ) ) );
+#endif
+}
+
+template <size_t I, size_t J, typename Comparable, size_t N>
+SORT_FIXED_CONSTEXPR void fixedSwapIf( array<Comparable, N> & a, bool swapped, false_type ) {
+    const Comparable x = a[ I ], y = a[ J ];
+    a[ I ] = swapped ? y : x;
+    a[ J ] = swapped ? x : y;
+}
+
+/**
+ * Internal methods for SortFixed.
+ * Puts the items at a[I] and a[J] in order. Integers under less<> or
+ * greater<> are equal only if identical, so each output gets its own
+ * select, which compiles to a conditional move. Other arithmetic items
+ * are exchanged by fixedSwapIf on a single comparison, so that items
+ * equivalent but not identical, as 0.0 and -0.0 are, are never
+ * duplicated.
+ */
+template <size_t I, size_t J, typename Comparable, size_t N, typename Comparator>
+SORT_FIXED_CONSTEXPR void fixedCompareExchange( array<Comparable, N> & a, Comparator & less_than, true_type ) {
+    if( RadixSortable<Comparable, Comparator>::value ) {
+        const Comparable x = a[ I ], y = a[ J ];
+        a[ I ] = less_than( y, x ) ? y : x;
+        a[ J ] = less_than( x, y ) ? y : x;
+    }
+    else
+        fixedSwapIf<I, J>( a, less_than( a[ J ], a[ I ] ), FixedBitBlend<Comparable>( ) );
 }
 
+template <size_t I, size_t J, typename Comparable, size_t N, typename Comparator>
+SORT_FIXED_CONSTEXPR void fixedCompareExchange( array<Comparable, N> & a, Comparator & less_than, false_type ) {
+    if( less_than( a[ J ], a[ I ] ) ) {
+        Comparable tmp = std::move( a[ I ] );
+        a[ I ] = std::move( a[ J ] );
+        a[ J ] = std::move( tmp );
+    }
+}
+
+/**
+ * Internal structs for SortFixed that unroll, at compile time, Batcher's
+ * odd-even merge sort network for N items:
+ *
+ *   for p = 1, 2, 4, ... < N
+ *     for k = p, p / 2, ..., 1
+ *       for j = k % p; j + k < N; j += 2k
+ *         for i = 0; i < k and i + j + k < N; ++i
+ *           if (i + j) / 2p == (i + j + k) / 2p
+ *             compare-exchange a[i + j] and a[i + j + k]
+ *
+ * one struct per loop. Comparators that would reach past N in the
+ * network for the next power of two are left out, as if the missing
+ * items were larger than all others. The result uses as many
+ * comparators as the best known networks up to 8 items, and 191 for 32
+ * items where the best known uses 185.
+ */
+template <size_t I, size_t J, bool Used>
+struct FixedComparator {
+    template <typename Comparable, size_t N, typename Comparator>
+    static SORT_FIXED_CONSTEXPR void apply( array<Comparable, N> & a, Comparator & less_than ) {
+        fixedCompareExchange<I, J>( a, less_than, is_arithmetic<Comparable>( ) );
+    }
+};
+
+template <size_t I, size_t J>
+struct FixedComparator<I, J, false> {
+    template <typename Comparable, size_t N, typename Comparator>
+    static SORT_FIXED_CONSTEXPR void apply( array<Comparable, N> &, Comparator & ) { }
+};
+
+template <size_t N, size_t P, size_t K, size_t J, size_t I, bool More = ( I < K && I + J + K < N )>
+struct FixedPairs {
+    template <typename Comparable, typename Comparator>
+    static SORT_FIXED_CONSTEXPR void apply( array<Comparable, N> & a, Comparator & less_than ) {
+        FixedComparator<I + J, I + J + K, ( I + J ) / ( 2 * P ) == ( I + J + K ) / ( 2 * P )>::apply( a, less_than );
+        FixedPairs<N, P, K, J, I + 1>::apply( a, less_than );
+    }
+};
+
+template <size_t N, size_t P, size_t K, size_t J, size_t I>
+struct FixedPairs<N, P, K, J, I, false> {
+    template <typename Comparable, typename Comparator>
+    static SORT_FIXED_CONSTEXPR void apply( array<Comparable, N> &, Comparator & ) { }
+};
+
+template <size_t N, size_t P, size_t K, size_t J, bool More = ( J + K < N )>
+struct FixedBlocks {
+    template <typename Comparable, typename Comparator>
+    static SORT_FIXED_CONSTEXPR void apply( array<Comparable, N> & a, Comparator & less_than ) {
+        FixedPairs<N, P, K, J, 0>::apply( a, less_than );
+        FixedBlocks<N, P, K, J + 2 * K>::apply( a, less_than );
+    }
+};
+
+template <size_t N, size_t P, size_t K, size_t J>
+struct FixedBlocks<N, P, K, J, false> {
+    template <typename Comparable, typename Comparator>
+    static SORT_FIXED_CONSTEXPR void apply( array<Comparable, N> &, Comparator & ) { }
+};
+
+template <size_t N, size_t P, size_t K, bool More = ( K >= 1 )>
+struct FixedMerges {
+    template <typename Comparable, typename Comparator>
+    static SORT_FIXED_CONSTEXPR void apply( array<Comparable, N> & a, Comparator & less_than ) {
+        FixedBlocks<N, P, K, K % P>::apply( a, less_than );
+        FixedMerges<N, P, K / 2>::apply( a, less_than );
+    }
+};
+
+template <size_t N, size_t P, size_t K>
+struct FixedMerges<N, P, K, false> {
+    template <typename Comparable, typename Comparator>
+    static SORT_FIXED_CONSTEXPR void apply( array<Comparable, N> &, Comparator & ) { }
+};
+
+template <size_t N, size_t P, bool More = ( P < N )>
+struct FixedNetwork {
+    template <typename Comparable, typename Comparator>
+    static SORT_FIXED_CONSTEXPR void apply( array<Comparable, N> & a, Comparator & less_than ) {
+        FixedMerges<N, P, P>::apply( a, less_than );
+        FixedNetwork<N, 2 * P>::apply( a, less_than );
+    }
+};
+
+template <size_t N, size_t P>
+struct FixedNetwork<N, P, false> {
+    template <typename Comparable, typename Comparator>
+    static SORT_FIXED_CONSTEXPR void apply( array<Comparable, N> &, Comparator & ) { }
+};
+
 //   Provide code for the following functions.
 //   See PDF for full details.
 //   Note that you will have to modify some of the functions above, or/and add new helper functions.
 
+// Driver for Sort: samples a for presortedness, runs, distinct keys and
+// key range, and sorts it with the engine expected to be fastest:
+// TimSort, counting sort, RadixSort or PdqSort. Is never quadratic.
+// @a: input/output vector to be sorted.
+// @less_than: Comparator to be used.
+// @log: if not null, the sample and the engine chosen are written to it.
+template <typename Array, typename Comparator>
+void Sort(Array & a, Comparator less_than, ostream * log = nullptr) {
+    SortProfile profile = SortProfile();
+    profile.size = a.size();
+    if (a.size() >= kSortSmall)
+      profile = profileSort(a, less_than);
+    const SortEngine engine = chooseSortEngine(profile);
+    if (log != nullptr)
+      logSortDecision(*log, profile, engine);
+
+    switch (engine) {
+      case SortEngine::Insertion: insertionSort(a, 0, int(a.size()) - 1, less_than); break;
+      case SortEngine::TimSort: timSort(a, less_than); break;
+      case SortEngine::Counting: countingSortIfPossible(a, less_than); break;
+      case SortEngine::Radix: radixSortIfPossible(a, less_than); break;
+      default: pdqsort(a, less_than); break;
+    }
+}
+
 // Driver for HeapSort.
 // @a: input/output vector to be sorted.
 // @less_than: Comparator to be used.
-template <typename Comparable, typename Comparator>
-void HeapSort(vector<Comparable> &a, Comparator less_than) {
+template <typename Array, typename Comparator>
+void HeapSort(Array & a, Comparator less_than) {
   // Add code. You can use any of functions above (afrer you modified them), or any other helper
   // function you write.
-  heapsort(a, less_than);
+  dAryHeapsort<4>(a, less_than);
 }
 
-// Driver for MergeSort.
+// Driver for MergeSort. Equal items keep their order.
 // @a: input/output vector to be sorted.
 // @less_than: Comparator to be used.
-template <typename Comparable, typename Comparator>
-void MergeSort(vector<Comparable> &a, Comparator less_than) {
+template <typename Array, typename Comparator>
+void MergeSort(Array & a, Comparator less_than) {
   // Add code. You can use any of functions above (afrer you modified them), or any other helper
   // function you write.
-    mergeSort(a, less_than);
+    if (!radixSortIfPossible(a, less_than))
+      mergeSortBottomUp(a, less_than);
 }
 
-// Driver for QuickSort (median of 3 partitioning).
+// Driver for MergeSort by a projection: sorts a by key_fn(item) under
+// less_than. Keys are computed once per item, and the sort is stable, so
+// a multi-key order can be built from successive passes, least
+// significant key first.
 // @a: input/output vector to be sorted.
+// @key_fn: returns the key of an item.
+// @less_than: Comparator to be used on the keys.
+template <typename Array, typename KeyFunction, typename Comparator>
+void MergeSort(Array & a, KeyFunction key_fn, Comparator less_than) {
+    projectionMergeSort(a, key_fn, less_than);
+}
+
+// Driver for TimSort (adaptive natural mergesort).
+// @a: input/output vector to be sorted.
+// @less_than: Comparator to be used.
+template <typename Array, typename Comparator>
+void TimSort(Array & a, Comparator less_than) {
+    timSort(a, less_than);
+}
+
+// Driver for InsertSorted: adds batch to the sorted vector a, keeping
+// it sorted. Only batch is sorted; it is then merged in from the back,
+// so the items of a that belong before all of it are not moved. Takes
+// O(m log m + n) time for a batch of m, with far fewer than n
+// comparisons when m is small. Items keep their order among equals,
+// with those of a first.
+// @a: sorted input/output vector; reserve room to avoid reallocation.
+// @batch: items to add, in any order.
 // @less_than: Comparator to be used.
 template <typename Comparable, typename Comparator>
-void QuickSort(vector<Comparable> &a, Comparator less_than) {
+void InsertSorted(vector<Comparable> & a, vector<Comparable> batch, Comparator less_than) {
+    MergeSort(batch, less_than);
+    const int n = a.size();
+    a.resize(n + batch.size());
+    mergeBackward(a, n, batch, less_than);
+}
+
+// Driver for parallel MergeSort.
+// @a: input/output vector to be sorted.
+// @less_than: Comparator to be used.
+// @num_threads: number of threads to use, 0 for one per hardware thread.
+template <typename Array, typename Comparator>
+void ParallelMergeSort(Array & a, Comparator less_than, int num_threads = 0) {
+    typedef typename Array::value_type Comparable;
+    vector<Comparable> tmpArray(a.size());
+    parallelMergeSort(a, tmpArray, 0, a.size() - 1, less_than, sortThreadCount(num_threads));
+}
+
+// Driver for QuickSort (median of 3 partitioning).
+// @a: input/output vector to be sorted.
+// @less_than: Comparator to be used.
+template <typename Array, typename Comparator>
+void QuickSort(Array & a, Comparator less_than) {
   // Add code. You can use any of functions above (afrer you modified them), or any other helper
   // function you write.
-    quicksort(a, less_than);
+    if (!radixSortIfPossible(a, less_than))
+      quicksort(a, less_than);
+}
+
+// Driver for parallel QuickSort (median of 3 partitioning, work stealing).
+// @a: input/output vector to be sorted.
+// @less_than: Comparator to be used.
+// @num_threads: number of threads to use, 0 for one per hardware thread.
+template <typename Array, typename Comparator>
+void ParallelQuickSort(Array & a, Comparator less_than, int num_threads = 0) {
+    parallelQuicksort(a, less_than, sortThreadCount(num_threads));
 }
 
 // Driver for QuickSort (middle pivot).
 // @a: input/output vector to be sorted.
 // @less_than: Comparator to be used.
-template <typename Comparable, typename Comparator>
-void QuickSort2(vector<Comparable> &a, Comparator less_than) {
+template <typename Array, typename Comparator>
+void QuickSort2(Array & a, Comparator less_than) {
   // quicksort implementation
   // to be filled
     quicksort2(a, less_than);
 }
 
 // Driver for quicksort using middle as pivot
-template <typename Comparable, typename Comparator>
-void QuickSort3(vector<Comparable> &a, Comparator less_than) {
+template <typename Array, typename Comparator>
+void QuickSort3(Array & a, Comparator less_than) {
   // quicksort implementation
   // to be filled
     quicksort3(a, less_than);
 }
 
+// Driver for IntroSort (median of 3 partitioning, heapsort fallback).
+// @a: input/output vector to be sorted.
+// @less_than: Comparator to be used.
+template <typename Array, typename Comparator>
+void IntroSort(Array & a, Comparator less_than) {
+    introsort(a, PivotRule::MedianOfThree, less_than);
+}
+
+// Driver for IntroSort (middle pivot, heapsort fallback).
+template <typename Array, typename Comparator>
+void IntroSort2(Array & a, Comparator less_than) {
+    introsort(a, PivotRule::Middle, less_than);
+}
+
+// Driver for IntroSort (first pivot, heapsort fallback).
+template <typename Array, typename Comparator>
+void IntroSort3(Array & a, Comparator less_than) {
+    introsort(a, PivotRule::First, less_than);
+}
+
+// Driver for pattern-defeating QuickSort (branchless block partitioning).
+// @a: input/output vector to be sorted.
+// @less_than: Comparator to be used.
+template <typename Array, typename Comparator>
+void PdqSort(Array & a, Comparator less_than) {
+    pdqsort(a, less_than);
+}
+
+// Driver for NthElement (introselect): places in a[n] the item that
+// would be there if a were sorted, with no greater item before it and no
+// smaller item after it. O(n) in the worst case.
+// @a: input/output vector to be partially ordered.
+// @n: index to be filled, from 0 to a.size() - 1.
+// @less_than: Comparator to be used.
+template <typename Array, typename Comparator>
+void NthElement(Array & a, int n, Comparator less_than) {
+    if (n >= 0 && size_t(n) < a.size())
+      introselect(a, n, less_than);
+}
+
+// Driver for PartialSort: moves the k smallest items of a, in order, to
+// a[0..k-1]. The other items are left in no particular order. Takes
+// O(n + k log k) time, by selection followed by a sort of the first k.
+// @a: input/output vector to be partially sorted.
+// @k: number of items wanted; all of a is sorted if k >= a.size().
+// @less_than: Comparator to be used.
+template <typename Array, typename Comparator>
+void PartialSort(Array & a, int k, Comparator less_than) {
+    k = int(min(size_t(max(k, 0)), a.size()));
+    if (k == 0)
+      return;
+    introselect(a, k - 1, less_than);
+    introsort(a, 0, k - 2, introsortDepthLimit(k - 1), PivotRule::MedianOfThree, less_than);
+}
+
+// Driver for three-way QuickSort (Bentley-McIlroy partitioning). Items
+// equal to the pivot are gathered in one pass and not sorted again, so
+// inputs with few distinct keys sort in near-linear time.
+// @a: input/output vector to be sorted.
+// @less_than: Comparator to be used.
+template <typename Array, typename Comparator>
+void QuickSort3Way(Array & a, Comparator less_than) {
+    quicksort3Way(a, less_than);
+}
+
+// Driver for LSD RadixSort. QuickSort and MergeSort use it automatically
+// for integers under less<> or greater<>.
+// @a: input/output vector of integers to be sorted.
+// @less_than: less<> or greater<>.
+template <typename Array, typename Comparator>
+void RadixSort(Array & a, Comparator) {
+    typedef typename Array::value_type Comparable;
+    static_assert(RadixSortable<Comparable, Comparator>::value,
+                  "RadixSort needs integer items and less<> or greater<>");
+    radixSort(a, RadixSortDescending<Comparator>::value);
+}
+
+// Driver for American flag sort (in-place MSD radix sort) of strings.
+// @a: input/output vector of strings or byte vectors to be sorted.
+// @less_than: less<> or greater<> for the string type.
+template <typename String, typename Comparator>
+void AmericanFlagSort(vector<String> &a, Comparator) {
+    static_assert(StringSortable<String, Comparator>::value,
+                  "AmericanFlagSort needs strings or byte vectors and less<> or greater<>");
+    americanFlagSort(a, 0, a.size() - 1, 0);
+    if (RadixSortDescending<Comparator>::value)
+      reverse(a.begin(), a.end());
+}
+
+// Driver for multikey QuickSort of strings.
+// @a: input/output vector of strings or byte vectors to be sorted.
+// @less_than: less<> or greater<> for the string type.
+template <typename String, typename Comparator>
+void MultikeyQuickSort(vector<String> &a, Comparator) {
+    static_assert(StringSortable<String, Comparator>::value,
+                  "MultikeyQuickSort needs strings or byte vectors and less<> or greater<>");
+    multikeyQuicksort(a, 0, a.size() - 1, 0);
+    if (RadixSortDescending<Comparator>::value)
+      reverse(a.begin(), a.end());
+}
+
+// Driver for ArgSort with QuickSort: leaves a alone and returns the
+// permutation that sorts it, for items that are costly to move.
+// @a: input vector to be ordered.
+// @less_than: Comparator to be used on the items of a.
+// Index may be a 32-bit or 64-bit integer type.
+template <typename Index = uint32_t, typename Array, typename Comparator>
+vector<Index> ArgQuickSort(const Array &a, Comparator less_than) {
+    vector<Index> permutation = identityPermutation<Index>(a.size());
+    quicksort(permutation, IndexLess<Array, Comparator>{&a, less_than});
+    return permutation;
+}
+
+// Driver for ArgSort with MergeSort. Equal items keep their order.
+// @a: input vector to be ordered.
+// @less_than: Comparator to be used on the items of a.
+template <typename Index = uint32_t, typename Array, typename Comparator>
+vector<Index> ArgMergeSort(const Array &a, Comparator less_than) {
+    vector<Index> permutation = identityPermutation<Index>(a.size());
+    mergeSortBottomUp(permutation, IndexLess<Array, Comparator>{&a, less_than});
+    return permutation;
+}
+
+// Driver for ArgSort with HeapSort.
+// @a: input vector to be ordered.
+// @less_than: Comparator to be used on the items of a.
+template <typename Index = uint32_t, typename Array, typename Comparator>
+vector<Index> ArgHeapSort(const Array &a, Comparator less_than) {
+    vector<Index> permutation = identityPermutation<Index>(a.size());
+    dAryHeapsort<4>(permutation, IndexLess<Array, Comparator>{&a, less_than});
+    return permutation;
+}
+
+// Driver for ApplyPermutation: moves each item of a once into the order
+// given by an argsort driver.
+// @a: input/output vector to be rearranged.
+// @permutation: a[i] receives the item at a[permutation[i]].
+template <typename Array, typename Index>
+void ApplyPermutation(Array &a, const vector<Index> &permutation) {
+    applyPermutation(a, permutation);
+}
+
+// Driver for SortFixed: sorts a std::array of N items with a sorting
+// network unrolled at compile time, Batcher's odd-even merge sort, with
+// no loops or branches on the data for arithmetic items. Meant for many
+// small arrays (N up to about 32); can be used in constant expressions
+// from C++17.
+// @a: input/output array to be sorted.
+// @less_than: Comparator to be used.
+template <size_t N, typename Comparable, typename Comparator>
+SORT_FIXED_CONSTEXPR void SortFixed(array<Comparable, N> &a, Comparator less_than) {
+    FixedNetwork<N, 1>::apply(a, less_than);
+}
+
 
 #endif  // SORT_H
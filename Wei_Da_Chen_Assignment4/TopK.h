@@ -0,0 +1,106 @@
+/**
+ * Streaming top-k: keeps the k items that come first in Comparator
+ * order out of any number of items pushed one at a time or in batches,
+ * in O(k) memory. Use greater<> to keep the k largest.
+ */
+
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include "Sort.h"
+
+#include <vector>
+using namespace std;
+
+template <typename Comparable, typename Comparator = less<Comparable>>
+class TopK {
+  public:
+    explicit TopK( size_t k, Comparator less_than = Comparator( ) )
+      : k( k ), less_than( less_than ) {
+        items.reserve( k );
+    }
+
+    /**
+     * Offers x. Once k items are held this costs one comparison with
+     * the root, the last of them, unless x takes its place.
+     */
+    void push( const Comparable & x ) {
+        if( items.size( ) < k )
+            fill( x );
+        else if( k > 0 && less_than( x, items[ 0 ] ) ) {
+            items[ 0 ] = x;
+            percDown( items, 0, k, less_than );
+        }
+    }
+
+    // Offers every item of batch, in order.
+    template <typename Array>
+    void pushBatch( const Array & batch ) {
+        size_t i = 0;
+        for( ; i < batch.size( ) && items.size( ) < k; ++i )
+            fill( batch[ i ] );
+        for( ; i < batch.size( ) && k > 0; ++i ) {
+            if( less_than( batch[ i ], items[ 0 ] ) ) {
+                items[ 0 ] = batch[ i ];
+                percDown( items, 0, k, less_than );
+            }
+        }
+    }
+
+    /**
+     * Offers the items held by other, such as the partial result of
+     * another thread.
+     */
+    void merge( const TopK & other ) {
+        pushBatch( other.items );
+    }
+
+    // Number of items held, at most capacity.
+    size_t size( ) const {
+        return items.size( );
+    }
+
+    size_t capacity( ) const {
+        return k;
+    }
+
+    bool empty( ) const {
+        return items.empty( );
+    }
+
+    /**
+     * The last of the items held, which an item must come before to be
+     * kept. Only valid once size( ) == capacity( ) > 0.
+     */
+    const Comparable & threshold( ) const {
+        return items[ 0 ];
+    }
+
+    // Returns the items held, in order.
+    vector<Comparable> sorted( ) const {
+        vector<Comparable> result = items;
+        heapsort( result, less_than );
+        return result;
+    }
+
+    void clear( ) {
+        items.clear( );
+    }
+
+  private:
+    size_t k;
+    Comparator less_than;
+    vector<Comparable> items;    // A heap with the last item at the root once full
+
+    // Appends x while fewer than k items are held, and builds the heap
+    // in O(k) when the k-th arrives.
+    void fill( const Comparable & x ) {
+        items.push_back( x );
+        if( items.size( ) == k ) {
+            for( int i = k / 2 - 1; i >= 0; --i )
+                percDown( items, i, k, less_than );
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,396 @@
+/*
+	File: benchmark_sorting_algorithms.cc
+*/
+
+/*
+Benchmark suite for the sorting algorithms in Sort.h.
+For every input distribution and size, each algorithm sorts identical copies
+of the same generated input: a few untimed warmup runs, then timed
+repetitions. The median, 95th percentile, mean and standard deviation of
+the repetitions are reported as a table, CSV or JSON.
+	- GenerateInput function generates the input of one distribution.
+	- Summarize function reduces the timed repetitions to statistics.
+	- Usage is printed by running with --help.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Sort.h"
+using namespace std;
+
+// Settings taken from the command line.
+struct BenchmarkOptions {
+  vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+  vector<string> distributions = {"random", "sorted", "reversed", "organ_pipe", "sawtooth", "few_unique", "zipf", "nearly_sorted"};
+  vector<string> algorithms;  // Empty for all
+  int warmup = 2;
+  int repetitions = 9;
+  double time_limit = 5;  // Seconds a run may take, or be expected to take, at the next size
+  string format = "table";
+  string output_path;
+  unsigned seed = 335;
+  bool help = false;  // Print usage and exit
+};
+
+// Statistics of the timed repetitions of one algorithm on one input, in ns.
+// runs is below the requested repetitions if a run went over the time limit.
+struct BenchmarkResult {
+  string distribution;
+  size_t size;
+  string algorithm;
+  double median;
+  double p95;
+  double mean;
+  double stddev;
+  double min;
+  int runs;
+  bool verified;
+  bool over_time_limit;
+};
+
+// An algorithm under test, sorting a vector of ints in increasing order.
+struct Algorithm {
+  string name;
+  function<void(vector<int> &)> sort;
+};
+
+// Returns every algorithm of Sort.h that sorts ints with a comparator, and
+// std::sort as a reference. QuickSort3 is left out: its first-item pivot
+// makes sorted, reversed and organ-pipe inputs quadratic.
+vector<Algorithm> AllAlgorithms() {
+  return {
+    {"Sort", [](vector<int> &a) { Sort(a, less<int>{}); }},
+    {"HeapSort", [](vector<int> &a) { HeapSort(a, less<int>{}); }},
+    {"MergeSort", [](vector<int> &a) { MergeSort(a, less<int>{}); }},
+    {"TimSort", [](vector<int> &a) { TimSort(a, less<int>{}); }},
+    {"ParallelMergeSort", [](vector<int> &a) { ParallelMergeSort(a, less<int>{}); }},
+    {"QuickSort", [](vector<int> &a) { QuickSort(a, less<int>{}); }},
+    {"QuickSort (comparisons only)", [](vector<int> &a) { quicksort(a, less<int>{}); }},
+    {"QuickSort2", [](vector<int> &a) { QuickSort2(a, less<int>{}); }},
+    {"QuickSort3Way", [](vector<int> &a) { QuickSort3Way(a, less<int>{}); }},
+    {"ParallelQuickSort", [](vector<int> &a) { ParallelQuickSort(a, less<int>{}); }},
+    {"IntroSort", [](vector<int> &a) { IntroSort(a, less<int>{}); }},
+    {"PdqSort", [](vector<int> &a) { PdqSort(a, less<int>{}); }},
+    {"RadixSort", [](vector<int> &a) { RadixSort(a, less<int>{}); }},
+    {"SORT", [](vector<int> &a) { SORT(a); }},
+    {"std::sort", [](vector<int> &a) { sort(a.begin(), a.end()); }},
+  };
+}
+
+// Generates and returns @size ints of the given @distribution:
+// random: uniform over all ints.
+// sorted / reversed: 0, 1, 2, ... in increasing / decreasing order.
+// organ_pipe: increasing to the middle, then decreasing.
+// sawtooth: 8 increasing runs.
+// few_unique: uniform over 8 values.
+// zipf: value k with probability proportional to 1 / k, over 1 .. 65536.
+// nearly_sorted: sorted, then 1% of the items swapped with random others.
+// Returns an empty vector for an unknown distribution.
+vector<int> GenerateInput(const string &distribution, size_t size, mt19937 &random) {
+  vector<int> input(size);
+  if (distribution == "random") {
+    uniform_int_distribution<int> uniform(numeric_limits<int>::min(), numeric_limits<int>::max());
+    for (size_t i = 0; i < size; i++)
+      input[i] = uniform(random);
+  }
+  else if (distribution == "sorted" || distribution == "nearly_sorted") {
+    for (size_t i = 0; i < size; i++)
+      input[i] = i;
+    if (distribution == "nearly_sorted" && size > 1) {
+      uniform_int_distribution<size_t> position(0, size - 1);
+      for (size_t swaps = 0; swaps < size / 100; swaps++)
+        swap(input[position(random)], input[position(random)]);
+    }
+  }
+  else if (distribution == "reversed") {
+    for (size_t i = 0; i < size; i++)
+      input[i] = size - i;
+  }
+  else if (distribution == "organ_pipe") {
+    for (size_t i = 0; i < size; i++)
+      input[i] = min(i, size - 1 - i);
+  }
+  else if (distribution == "sawtooth") {
+    const size_t tooth = max<size_t>(size / 8, 1);
+    for (size_t i = 0; i < size; i++)
+      input[i] = i % tooth;
+  }
+  else if (distribution == "few_unique") {
+    uniform_int_distribution<int> uniform(0, 7);
+    for (size_t i = 0; i < size; i++)
+      input[i] = uniform(random);
+  }
+  else if (distribution == "zipf") {
+    const int kValues = 1 << 16;
+    vector<double> cumulative(kValues);
+    double total = 0;
+    for (int k = 1; k <= kValues; k++)
+      cumulative[k - 1] = total += 1.0 / k;
+    uniform_real_distribution<double> uniform(0, total);
+    for (size_t i = 0; i < size; i++)
+      input[i] = upper_bound(cumulative.begin(), cumulative.end(), uniform(random)) - cumulative.begin() + 1;
+  }
+  else {
+    input.clear();
+  }
+  return input;
+}
+
+// Returns the @q quantile (0 to 1) of the sorted @samples, interpolating
+// between the two nearest ranks.
+double Quantile(const vector<double> &samples, double q) {
+  const double rank = q * (samples.size() - 1);
+  const size_t below = size_t(rank);
+  if (below + 1 >= samples.size())
+    return samples.back();
+  return samples[below] + (rank - below) * (samples[below + 1] - samples[below]);
+}
+
+// Fills the statistics of @result from the runtimes in @samples.
+void Summarize(vector<double> samples, BenchmarkResult &result) {
+  sort(samples.begin(), samples.end());
+  result.median = Quantile(samples, 0.5);
+  result.p95 = Quantile(samples, 0.95);
+  result.min = samples.front();
+  double sum = 0;
+  for (double sample : samples)
+    sum += sample;
+  result.mean = sum / samples.size();
+  double squares = 0;
+  for (double sample : samples)
+    squares += (sample - result.mean) * (sample - result.mean);
+  result.stddev = samples.size() > 1 ? sqrt(squares / (samples.size() - 1)) : 0.0;
+}
+
+// Runs @algorithm on copies of @input: @options.warmup untimed runs, then
+// @options.repetitions timed ones. Copying is not timed. The result of the
+// first run is checked against std::sort. A run longer than
+// @options.time_limit ends the benchmark early, keeping the runs timed so
+// far, or that run if it was a warmup run.
+BenchmarkResult RunBenchmark(const Algorithm &algorithm, const vector<int> &input, const vector<int> &expected,
+                             const BenchmarkOptions &options) {
+  BenchmarkResult result;
+  result.algorithm = algorithm.name;
+  result.size = input.size();
+  result.over_time_limit = false;
+
+  vector<int> copy;
+  vector<double> samples;
+  for (int run = 0; run < options.warmup + options.repetitions; run++) {
+    copy = input;
+    const auto beginTime = chrono::high_resolution_clock::now();
+    algorithm.sort(copy);
+    const auto endTime = chrono::high_resolution_clock::now();
+    const double duration = chrono::duration<double, nano>(endTime - beginTime).count();
+    if (run == 0)
+      result.verified = copy == expected;
+    if (run >= options.warmup)
+      samples.push_back(duration);
+    if (duration > options.time_limit * 1e9) {
+      if (samples.empty())
+        samples.push_back(duration);
+      result.over_time_limit = true;
+      break;
+    }
+  }
+  result.runs = samples.size();
+  Summarize(samples, result);
+  return result;
+}
+
+// Predicts the time in ns of one run of an algorithm at @size from its
+// @previous result at a smaller size, assuming quadratic growth, the worst
+// case of the algorithms benchmarked.
+double PredictedDuration(const BenchmarkResult &previous, size_t size) {
+  const double ratio = double(size) / previous.size;
+  return previous.median * ratio * ratio;
+}
+
+// Escapes @text for a JSON string.
+string JsonString(const string &text) {
+  string escaped = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      escaped += '\\';
+    escaped += c;
+  }
+  return escaped + "\"";
+}
+
+// Writes @results to @out in the format chosen in @options.
+void WriteResults(const vector<BenchmarkResult> &results, const BenchmarkOptions &options, ostream &out) {
+  if (options.format == "csv") {
+    out << "distribution,size,algorithm,median_ns,p95_ns,mean_ns,stddev_ns,min_ns,runs,verified\n";
+    for (const BenchmarkResult &r : results)
+      out << r.distribution << "," << r.size << ",\"" << r.algorithm << "\"," << r.median << "," << r.p95 << ","
+          << r.mean << "," << r.stddev << "," << r.min << "," << r.runs << "," << r.verified << "\n";
+  }
+  else if (options.format == "json") {
+    out << "{\n  \"warmup\": " << options.warmup << ",\n  \"repetitions\": " << options.repetitions
+        << ",\n  \"seed\": " << options.seed << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+      const BenchmarkResult &r = results[i];
+      out << "    {\"distribution\": " << JsonString(r.distribution) << ", \"size\": " << r.size
+          << ", \"algorithm\": " << JsonString(r.algorithm) << ", \"median_ns\": " << r.median
+          << ", \"p95_ns\": " << r.p95 << ", \"mean_ns\": " << r.mean << ", \"stddev_ns\": " << r.stddev
+          << ", \"min_ns\": " << r.min << ", \"runs\": " << r.runs << ", \"verified\": " << (r.verified ? "true" : "false") << "}"
+          << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+  }
+  else {
+    out << left << setw(14) << "distribution" << setw(10) << "size" << setw(30) << "algorithm" << right
+        << setw(14) << "median (ms)" << setw(12) << "p95 (ms)" << setw(12) << "stddev" << setw(6) << "runs"
+        << setw(10) << "verified" << "\n";
+    for (const BenchmarkResult &r : results)
+      out << left << setw(14) << r.distribution << setw(10) << r.size << setw(30) << r.algorithm << right << fixed
+          << setprecision(3) << setw(14) << r.median / 1e6 << setw(12) << r.p95 / 1e6 << setw(12) << r.stddev / 1e6
+          << setw(6) << r.runs << setw(10) << r.verified << "\n";
+  }
+}
+
+// Splits @text at commas.
+vector<string> SplitList(const string &text) {
+  vector<string> items;
+  stringstream stream(text);
+  string item;
+  while (getline(stream, item, ','))
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+void PrintUsage(const char *program) {
+  cout << "Usage: " << program << " [options]\n"
+       << "  --sizes N,N,...          input sizes (default 1000,10000,100000,1000000)\n"
+       << "  --distributions D,D,...  random, sorted, reversed, organ_pipe, sawtooth,\n"
+       << "                           few_unique, zipf, nearly_sorted (default all)\n"
+       << "  --algorithms A,A,...     algorithm names as printed (default all)\n"
+       << "  --warmup N               untimed runs per algorithm (default 2)\n"
+       << "  --repetitions N          timed runs per algorithm (default 9)\n"
+       << "  --time-limit SECONDS     a run longer than this stops the algorithm's runs on\n"
+       << "                           this input and skips larger sizes; a size where a\n"
+       << "                           run is expected to take longer, scaling the last\n"
+       << "                           size's time quadratically, is skipped (default 5)\n"
+       << "  --format table|csv|json  output format (default table)\n"
+       << "  --output PATH            write results to PATH instead of stdout\n"
+       << "  --seed N                 seed for the generated inputs (default 335)\n";
+}
+
+// Parses the command line into @options. Returns false on a bad argument.
+bool ParseOptions(int argc, char **argv, BenchmarkOptions &options) {
+  for (int i = 1; i < argc; i++) {
+    const string flag = argv[i];
+    if (flag == "--help") {
+      options.help = true;
+      return true;
+    }
+    if (i + 1 >= argc)
+      return false;
+    const string value = argv[++i];
+    if (flag == "--sizes") {
+      options.sizes.clear();
+      for (const string &size : SplitList(value))
+        options.sizes.push_back(stoul(size));
+    }
+    else if (flag == "--distributions")
+      options.distributions = SplitList(value);
+    else if (flag == "--algorithms")
+      options.algorithms = SplitList(value);
+    else if (flag == "--warmup")
+      options.warmup = stoi(value);
+    else if (flag == "--repetitions")
+      options.repetitions = stoi(value);
+    else if (flag == "--time-limit")
+      options.time_limit = stod(value);
+    else if (flag == "--format")
+      options.format = value;
+    else if (flag == "--output")
+      options.output_path = value;
+    else if (flag == "--seed")
+      options.seed = stoul(value);
+    else
+      return false;
+  }
+  sort(options.sizes.begin(), options.sizes.end());
+  return options.warmup >= 0 && options.repetitions > 0 && options.time_limit > 0 &&
+         (options.format == "table" || options.format == "csv" || options.format == "json");
+}
+
+int main(int argc, char **argv) {
+  BenchmarkOptions options;
+  bool parsed;
+  try {
+    parsed = ParseOptions(argc, argv, options);
+  }
+  catch (const exception &) {
+    parsed = false;
+  }
+  if (!parsed || options.help) {
+    PrintUsage(argv[0]);
+    return parsed ? 0 : 1;
+  }
+
+  vector<Algorithm> algorithms;
+  for (const Algorithm &algorithm : AllAlgorithms())
+    if (options.algorithms.empty() || find(options.algorithms.begin(), options.algorithms.end(), algorithm.name) != options.algorithms.end())
+      algorithms.push_back(algorithm);
+
+  mt19937 random(options.seed);
+  vector<BenchmarkResult> results;
+  for (const string &distribution : options.distributions) {
+    // Last result of each algorithm at a smaller size
+    map<string, BenchmarkResult> previous;
+    for (size_t size : options.sizes) {
+      const vector<int> input = GenerateInput(distribution, size, random);
+      if (input.size() != size) {
+        cerr << "Unknown distribution: " << distribution << endl;
+        return 1;
+      }
+      vector<int> expected = input;
+      sort(expected.begin(), expected.end());
+
+      for (const Algorithm &algorithm : algorithms) {
+        const auto last = previous.find(algorithm.name);
+        if (last != previous.end() && last->second.over_time_limit) {
+          cerr << distribution << " " << size << " " << algorithm.name << ": skipped, over the time limit at a smaller size" << endl;
+          continue;
+        }
+        if (last != previous.end() && PredictedDuration(last->second, size) > options.time_limit * 1e9) {
+          cerr << distribution << " " << size << " " << algorithm.name << ": skipped, expected to take "
+               << PredictedDuration(last->second, size) / 1e9 << " s from size " << last->second.size << endl;
+          continue;
+        }
+        results.push_back(RunBenchmark(algorithm, input, expected, options));
+        results.back().distribution = distribution;
+        cerr << distribution << " " << size << " " << algorithm.name << ": "
+             << results.back().median / 1e6 << " ms" << endl;
+        previous[algorithm.name] = results.back();
+      }
+    }
+  }
+
+  if (options.output_path.empty()) {
+    WriteResults(results, options, cout);
+  }
+  else {
+    ofstream output(options.output_path);
+    WriteResults(results, options, output);
+    if (!output) {
+      cerr << "Cannot write " << options.output_path << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -16,13 +16,22 @@ Comparator class to be used for comparisons.
 		and returns it.
 */
 
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <functional>
 #include <string>
 #include <vector>
 #include "Sort.h"
+#include "ExternalSort.h"
+#include "MappedFile.h"
+#include "OperationCounts.h"
+#include "PerfCounters.h"
+#include "TopK.h"
 using namespace std;
 
 // Computes duration given a start time and a stop time in nano seconds.
@@ -31,6 +40,54 @@ long long ComputeDuration(chrono::high_resolution_clock::time_point start_time,
   return chrono::duration_cast<chrono::nanoseconds>(end_time - start_time).count();
 }
 
+// Returns the hardware counters read around each timed driver call when the
+// SORT_PERF_COUNTERS environment variable is set. Returns null otherwise, or
+// when no counter can be opened, in which case the reason is printed once.
+PerfCounters *DriverCounters() {
+  static PerfCounters *counters = []() -> PerfCounters * {
+    if (getenv("SORT_PERF_COUNTERS") == nullptr)
+      return nullptr;
+    static PerfCounters perf;
+    if (!perf.available()) {
+      cout << "Performance counters unavailable: " << perf.error() << endl;
+      return nullptr;
+    }
+    return &perf;
+  }();
+  return counters;
+}
+
+// Start and stop the driver counters, if enabled. Called outside the timed
+// region so that they do not add to the runtime. StopCounters returns the
+// readings of the interval, for tests that time something else before
+// printing them; they are empty if the counters are disabled.
+void StartCounters() {
+  if (DriverCounters() != nullptr)
+    DriverCounters()->start();
+}
+
+vector<PerfCounters::Reading> StopCounters() {
+  if (DriverCounters() == nullptr)
+    return vector<PerfCounters::Reading>();
+  DriverCounters()->stop();
+  return DriverCounters()->read();
+}
+
+// Prints each of @readings per element of an input of @size.
+void PrintCounterRates(const vector<PerfCounters::Reading> &readings, size_t size) {
+  if (size == 0)
+    return;
+  for (const PerfCounters::Reading &reading : readings)
+    cout << reading.name << "/element: " << reading.value / size << "\n";
+}
+
+// Prints each counter of the last StartCounters/StopCounters interval per
+// element of an input of @size, if the counters are enabled.
+void PrintCounterRates(size_t size) {
+  if (DriverCounters() != nullptr)
+    PrintCounterRates(DriverCounters()->read(), size);
+}
+
 // Test function that shows how you can time a piece of code.
 // Just times a simple loop. Remove for final submission.
 
@@ -79,24 +136,620 @@ vector<int> GenerateSortedVector(size_t size_of_vector, bool smaller_to_larger)
   return sorted_vector;
 }
 
-// Verifies that a vector is sorted given a comparator.
+// Generates and returns a random vector of size @size_of_vector holding
+// only @distinct different values, like a status-code or category column.
+vector<int> GenerateFewUniqueVector(size_t size_of_vector, int distinct) {
+  vector<int> few_uniqueVector;
+  srand(time(0));
+
+  for (unsigned int i = 0; i < size_of_vector; i++) {
+    few_uniqueVector.push_back(rand() % distinct);
+  }
+
+  return few_uniqueVector;
+}
+
+// Turns each number of @numbers into a URL-like string. The strings share
+// long prefixes, like the log lines and URLs the string sorts are aimed at.
+vector<string> GenerateStringVector(const vector<int> &numbers) {
+  vector<string> strings;
+  for (int number : numbers) {
+    strings.push_back("https://www.example.com/catalog/item/" + to_string(number));
+  }
+  return strings;
+}
+
+// Generates a vector of doubles from @numbers: -0.0 for each even number
+// and the odd ones modulo 5, so that many items are 0.0 or -0.0, equal
+// but not identical.
+vector<double> GenerateSignedZeroVector(const vector<int> &numbers) {
+  vector<double> doubles;
+  for (int number : numbers) {
+    doubles.push_back(number % 2 == 0 ? -0.0 : double(number % 5));
+  }
+  return doubles;
+}
+
+// Verifies that a vector (or Span) is sorted given a comparator.
 // I.e. it applies less_than() for consecutive pair of elements and returns true
 // iff less_than() is true for all pairs.
-template <typename Comparable, typename Comparator>
-bool VerifyOrder(const vector<Comparable> &input, Comparator less_than) {
-  for (unsigned i = 1; i < input.size(); i++) {
+template <typename Array, typename Comparator>
+bool VerifyOrder(const Array &input, Comparator less_than) {
+  for (size_t i = 1; i < input.size(); i++) {
     if (input[i] != input[i - 1] && less_than(input[i], input[i - 1]))
       return false;
   }
   return true;
 }
 
+// Runs @sorter on a copy of @input and prints its runtime and whether the
+// result is in the order given by @less_than. Returns the runtime in ns.
+template <typename Comparable, typename Sorter, typename Comparator>
+long long TestSortingAlgorithm(const string &name, const vector<Comparable> &input, Sorter sorter, Comparator less_than) {
+  vector<Comparable> sorted_vector = input;
+  StartCounters();
+  const auto beginTime = chrono::high_resolution_clock::now();
+  sorter(sorted_vector);
+  const auto endTime = chrono::high_resolution_clock::now();
+  StopCounters();
+  const long long duration = ComputeDuration(beginTime, endTime);
+  cout << name << endl << "Runtime: " << duration << " ns\n";
+  PrintCounterRates(input.size());
+  cout << "Verified: " << VerifyOrder(sorted_vector, less_than) << "\n";
+  return duration;
+}
+
+// Like TestSortingAlgorithm, but also verifies that the result keeps the
+// number of negative items of @input, which the order check misses when
+// items equal but not identical, as 0.0 and -0.0 are, get duplicated.
+template <typename Comparable, typename Sorter, typename Comparator>
+void TestSignedSortingAlgorithm(const string &name, const vector<Comparable> &input, Sorter sorter, Comparator less_than) {
+  vector<Comparable> sorted_vector = input;
+  StartCounters();
+  const auto beginTime = chrono::high_resolution_clock::now();
+  sorter(sorted_vector);
+  const auto endTime = chrono::high_resolution_clock::now();
+  StopCounters();
+  auto negative = [](Comparable x) { return signbit(x); };
+  cout << name << endl << "Runtime: " << ComputeDuration(beginTime, endTime) << " ns\n";
+  PrintCounterRates(input.size());
+  cout << "Verified: " << (VerifyOrder(sorted_vector, less_than) &&
+                           count_if(sorted_vector.begin(), sorted_vector.end(), negative) ==
+                           count_if(input.begin(), input.end(), negative)) << "\n";
+}
+
+// Sorts @input as doubles and floats full of 0.0 and -0.0, and as int64_t
+// and uint32_t, with QuickSort and IntroSort under Order, so that every
+// item type of the sorting network leaves is run.
+template <template <typename> class Order>
+void TestNetworkLeaves(const vector<int> &input) {
+  const vector<double> doubles = GenerateSignedZeroVector(input);
+  const vector<float> floats(doubles.begin(), doubles.end());
+  vector<int64_t> longs;
+  vector<uint32_t> unsigneds;
+  for (int number : input) {
+    longs.push_back(int64_t(number) * 65536);
+    unsigneds.push_back(uint32_t(number));
+  }
+
+  TestSignedSortingAlgorithm("QuickSort (doubles)", doubles, [](vector<double> &a) { QuickSort(a, Order<double>{}); }, Order<double>{});
+  TestSignedSortingAlgorithm("IntroSort (doubles)", doubles, [](vector<double> &a) { IntroSort(a, Order<double>{}); }, Order<double>{});
+  TestSignedSortingAlgorithm("QuickSort (floats)", floats, [](vector<float> &a) { QuickSort(a, Order<float>{}); }, Order<float>{});
+  TestSignedSortingAlgorithm("IntroSort (floats)", floats, [](vector<float> &a) { IntroSort(a, Order<float>{}); }, Order<float>{});
+  TestSignedSortingAlgorithm("IntroSort (int64_t)", longs, [](vector<int64_t> &a) { IntroSort(a, Order<int64_t>{}); }, Order<int64_t>{});
+  TestSignedSortingAlgorithm("IntroSort (uint32_t)", unsigneds, [](vector<uint32_t> &a) { IntroSort(a, Order<uint32_t>{}); }, Order<uint32_t>{});
+}
+
+// Counting policy of the operation counts test. With NoOperationCounts
+// its items and comparators are plain ints and std::less / std::greater.
+typedef CountOperations DriverCountPolicy;
+typedef CountedFor<int, DriverCountPolicy> CountedInt;
+template <typename Comparator>
+using DriverComparator = CountingComparatorFor<Comparator, DriverCountPolicy>;
+
+// Sorts a copy of @input as CountedInt items with @sorter and a counting
+// @less_than, and prints the runtime beside the comparisons, copies and moves
+// made per element, to tell runs bound by comparisons from runs bound by
+// data movement.
+template <typename Sorter, typename Comparator>
+void TestOperationCounts(const string &name, const vector<int> &input, Sorter sorter, Comparator less_than) {
+  vector<CountedInt> counted_vector(input.begin(), input.end());
+  DriverCountPolicy::reset();
+  StartCounters();
+  const auto beginTime = chrono::high_resolution_clock::now();
+  sorter(counted_vector, DriverComparator<Comparator>{less_than});
+  const auto endTime = chrono::high_resolution_clock::now();
+  StopCounters();
+  const OperationCounts counts = DriverCountPolicy::read();
+  const double size = max<size_t>(input.size(), 1);
+  cout << name << endl << "Runtime: " << ComputeDuration(beginTime, endTime) << " ns\n";
+  PrintCounterRates(input.size());
+  cout << "Comparisons: " << counts.comparisons << " (" << counts.comparisons / size << "/element)\n";
+  cout << "Copies: " << counts.copies << " (" << counts.copies / size << "/element)\n";
+  cout << "Moves: " << counts.moves << " (" << counts.moves / size << "/element)\n";
+  cout << "Verified: " << VerifyOrder(counted_vector, less_than) << "\n";
+}
+
+// Runs ParallelQuickSort on a copy of @input with 1, 2, 4, ... threads up to
+// @max_threads and prints the runtime and throughput of each run.
+template <typename Comparator>
+void TestParallelQuickSort(const vector<int> &input, Comparator less_than, int max_threads) {
+  for (int threads = 1; ; threads = min(threads * 2, max_threads)) {
+    vector<int> parallel_quick_sortVector = input;
+    StartCounters();
+    const auto beginTime = chrono::high_resolution_clock::now();
+    ParallelQuickSort(parallel_quick_sortVector, less_than, threads);
+    const auto endTime = chrono::high_resolution_clock::now();
+    StopCounters();
+    const long long duration = ComputeDuration(beginTime, endTime);
+    cout << "Parallel QuickSort (" << threads << " threads)" << endl << "Runtime: " << duration << " ns\n";
+    cout << "Throughput: " << (duration > 0 ? input.size() * 1000.0 / duration : 0.0) << " million elements/s\n";
+    PrintCounterRates(input.size());
+    cout << "Verified: " << VerifyOrder(parallel_quick_sortVector, less_than) << "\n";
+    if (threads == max_threads)
+      break;
+    cout << endl;
+  }
+}
+
+// Times one partition pass over a copy of @input: the scalar loop of
+// QuickSort (medianOf3Partition) against median3 followed by simdPartition,
+// and prints the speedup of the vectorized pass.
+template <typename Comparator>
+void TestPartitionPass(const vector<int> &input, Comparator less_than) {
+  const int last = int(input.size()) - 1;
+  if (last < kSimdPartitionCutoff + 2) {
+    cout << "Partition pass: input too small\n";
+    return;
+  }
+
+  vector<int> scalar_partitionVector = input;
+  StartCounters();
+  const auto beginTime = chrono::high_resolution_clock::now();
+  medianOf3Partition(scalar_partitionVector, 0, last, less_than);
+  const auto endTime = chrono::high_resolution_clock::now();
+  StopCounters();
+  const long long scalar_duration = ComputeDuration(beginTime, endTime);
+  cout << "Partition pass (scalar)" << endl << "Runtime: " << scalar_duration << " ns\n";
+  PrintCounterRates(input.size());
+
+  vector<int> simd_partitionVector = input;
+  int boundary;
+  bool left_equals_pivot = false;
+  StartCounters();
+  const auto beginTime1 = chrono::high_resolution_clock::now();
+  const int pivot = median3(simd_partitionVector, 0, last, less_than);
+  const bool vectorized = simdPartition(simd_partitionVector, 1, last - 2, pivot, less_than, boundary, left_equals_pivot);
+  const auto endTime1 = chrono::high_resolution_clock::now();
+  StopCounters();
+  const long long simd_duration = ComputeDuration(beginTime1, endTime1);
+  if (!vectorized) {
+    cout << "Partition pass (SIMD): unavailable on this CPU\n";
+    return;
+  }
+  cout << "Partition pass (SIMD)" << endl << "Runtime: " << simd_duration << " ns\n";
+  PrintCounterRates(input.size());
+  cout << "Speedup: " << (simd_duration > 0 ? double(scalar_duration) / simd_duration : 0.0) << "x\n";
+}
+
+// A 200-byte record keyed on an int, standing in for items that are far
+// costlier to move than to compare.
+struct LargeRecord {
+  int key;
+  char payload[196];
+};
+
+// Returns the keys of @records, in order.
+vector<int> RecordKeys(const vector<LargeRecord> &records) {
+  vector<int> keys(records.size());
+  for (size_t i = 0; i < records.size(); i++)
+    keys[i] = records[i].key;
+  return keys;
+}
+
+// Times @sorter moving whole LargeRecords against @arg_sorter ordering 32-bit
+// indices followed by a single ApplyPermutation, on copies of @records.
+template <typename Sorter, typename ArgSorter, typename Comparator>
+void TestArgSortPair(const string &name, const vector<LargeRecord> &records, Sorter sorter, ArgSorter arg_sorter, Comparator less_than) {
+  vector<LargeRecord> direct_sortVector = records;
+  StartCounters();
+  const auto beginTime = chrono::high_resolution_clock::now();
+  sorter(direct_sortVector);
+  const auto endTime = chrono::high_resolution_clock::now();
+  StopCounters();
+  const long long direct_duration = ComputeDuration(beginTime, endTime);
+  cout << name << " (records)" << endl << "Runtime: " << direct_duration << " ns\n";
+  PrintCounterRates(records.size());
+  cout << "Verified: " << VerifyOrder(RecordKeys(direct_sortVector), less_than) << "\n";
+
+  vector<LargeRecord> arg_sortVector = records;
+  StartCounters();
+  const auto beginTime1 = chrono::high_resolution_clock::now();
+  const vector<uint32_t> permutation = arg_sorter(arg_sortVector);
+  ApplyPermutation(arg_sortVector, permutation);
+  const auto endTime1 = chrono::high_resolution_clock::now();
+  StopCounters();
+  const long long arg_duration = ComputeDuration(beginTime1, endTime1);
+  cout << "Arg" << name << " + ApplyPermutation" << endl << "Runtime: " << arg_duration << " ns\n";
+  PrintCounterRates(records.size());
+  cout << "Verified: " << VerifyOrder(RecordKeys(arg_sortVector), less_than) << "\n";
+  cout << "Speedup: " << (arg_duration > 0 ? double(direct_duration) / arg_duration : 0.0) << "x\n";
+}
+
+// Compares sorting LargeRecords keyed by @input directly and through the
+// argsort drivers, for QuickSort, MergeSort and HeapSort.
+template <typename Comparator>
+void TestArgSort(const vector<int> &input, Comparator less_than) {
+  vector<LargeRecord> records(input.size());
+  for (size_t i = 0; i < input.size(); i++) {
+    records[i].key = input[i];
+    memset(records[i].payload, int(i), sizeof(records[i].payload));
+  }
+  auto record_less = [less_than](const LargeRecord &lhs, const LargeRecord &rhs) { return less_than(lhs.key, rhs.key); };
+  typedef vector<LargeRecord> Records;
+
+  TestArgSortPair("QuickSort", records, [&](Records &a) { QuickSort(a, record_less); },
+                  [&](const Records &a) { return ArgQuickSort(a, record_less); }, less_than);
+  cout << endl;
+  TestArgSortPair("MergeSort", records, [&](Records &a) { MergeSort(a, record_less); },
+                  [&](const Records &a) { return ArgMergeSort(a, record_less); }, less_than);
+  cout << endl;
+  TestArgSortPair("HeapSort", records, [&](Records &a) { HeapSort(a, record_less); },
+                  [&](const Records &a) { return ArgHeapSort(a, record_less); }, less_than);
+}
+
+// Sorts (@input / 1000, @input % 1000) pairs on both fields: once with a
+// tuple comparator, and once with two stable projection MergeSort passes,
+// least significant field first. Prints both runtimes and whether the
+// results agree.
+template <typename Comparator>
+void TestProjectionSort(const vector<int> &input, Comparator less_than) {
+  vector<pair<int, int>> items(input.size());
+  for (size_t i = 0; i < input.size(); i++)
+    items[i] = make_pair(input[i] / 1000, input[i] % 1000);
+
+  vector<pair<int, int>> tuple_sortVector = items;
+  StartCounters();
+  const auto beginTime = chrono::high_resolution_clock::now();
+  MergeSort(tuple_sortVector, [less_than](const pair<int, int> &lhs, const pair<int, int> &rhs) {
+    if (less_than(lhs.first, rhs.first))
+      return true;
+    return !less_than(rhs.first, lhs.first) && less_than(lhs.second, rhs.second);
+  });
+  const auto endTime = chrono::high_resolution_clock::now();
+  StopCounters();
+  const long long tuple_duration = ComputeDuration(beginTime, endTime);
+  cout << "MergeSort (tuple comparator)" << endl << "Runtime: " << tuple_duration << " ns\n";
+  PrintCounterRates(items.size());
+
+  vector<pair<int, int>> projection_sortVector = items;
+  StartCounters();
+  const auto beginTime1 = chrono::high_resolution_clock::now();
+  MergeSort(projection_sortVector, [](const pair<int, int> &item) { return item.second; }, less_than);
+  MergeSort(projection_sortVector, [](const pair<int, int> &item) { return item.first; }, less_than);
+  const auto endTime1 = chrono::high_resolution_clock::now();
+  StopCounters();
+  const long long projection_duration = ComputeDuration(beginTime1, endTime1);
+  cout << "MergeSort (2 projection passes)" << endl << "Runtime: " << projection_duration << " ns\n";
+  PrintCounterRates(items.size());
+  cout << "Verified: " << (projection_sortVector == tuple_sortVector) << "\n";
+  cout << "Speedup: " << (projection_duration > 0 ? double(tuple_duration) / projection_duration : 0.0) << "x\n";
+}
+
+// Reads the 50th, 99th and 99.9th percentiles of @input with NthElement,
+// and its 100 first items with PartialSort, and times both against
+// sorting the whole input with QuickSort, which also verifies them.
+template <typename Comparator>
+void TestSelection(const vector<int> &input, Comparator less_than) {
+  if (input.empty())
+    return;
+  const vector<double> quantiles = {0.5, 0.99, 0.999};
+
+  vector<int> quick_sortVector = input;
+  StartCounters();
+  const auto beginTime = chrono::high_resolution_clock::now();
+  QuickSort(quick_sortVector, less_than);
+  const auto endTime = chrono::high_resolution_clock::now();
+  StopCounters();
+  const long long sort_duration = ComputeDuration(beginTime, endTime);
+  cout << "QuickSort" << endl << "Runtime: " << sort_duration << " ns\n";
+  PrintCounterRates(input.size());
+
+  vector<int> nth_elementVector = input;
+  bool nth_verified = true;
+  StartCounters();
+  const auto beginTime1 = chrono::high_resolution_clock::now();
+  for (double q : quantiles) {
+    const int rank = int(q * (input.size() - 1));
+    NthElement(nth_elementVector, rank, less_than);
+    nth_verified = nth_verified && nth_elementVector[rank] == quick_sortVector[rank];
+  }
+  const auto endTime1 = chrono::high_resolution_clock::now();
+  StopCounters();
+  const long long nth_duration = ComputeDuration(beginTime1, endTime1);
+  cout << "NthElement (p50, p99, p999)" << endl << "Runtime: " << nth_duration << " ns\n";
+  PrintCounterRates(input.size());
+  cout << "Verified: " << nth_verified << "\n";
+  cout << "Speedup over QuickSort: " << (nth_duration > 0 ? double(sort_duration) / nth_duration : 0.0) << "x\n";
+
+  const int k = int(min<size_t>(100, input.size()));
+  vector<int> partial_sortVector = input;
+  StartCounters();
+  const auto beginTime2 = chrono::high_resolution_clock::now();
+  PartialSort(partial_sortVector, k, less_than);
+  const auto endTime2 = chrono::high_resolution_clock::now();
+  StopCounters();
+  const long long partial_duration = ComputeDuration(beginTime2, endTime2);
+  cout << "PartialSort (first " << k << ")" << endl << "Runtime: " << partial_duration << " ns\n";
+  PrintCounterRates(input.size());
+  cout << "Verified: " << equal(partial_sortVector.begin(), partial_sortVector.begin() + k, quick_sortVector.begin()) << "\n";
+  cout << "Speedup over QuickSort: " << (partial_duration > 0 ? double(sort_duration) / partial_duration : 0.0) << "x\n";
+}
+
+// Streams @input in batches through one TopK per thread, merges the
+// partial results, and checks them against PartialSort on a copy.
+template <typename Comparator>
+void TestTopK(const vector<int> &input, Comparator less_than, int num_threads) {
+  const size_t k = min<size_t>(100, input.size());
+  const size_t kBatchSize = 4096;
+
+  StartCounters();
+  const auto beginTime = chrono::high_resolution_clock::now();
+  vector<TopK<int, Comparator>> partial(num_threads, TopK<int, Comparator>(k, less_than));
+  vector<thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      const size_t first = input.size() * t / num_threads, last = input.size() * (t + 1) / num_threads;
+      for (size_t begin = first; begin < last; begin += kBatchSize)
+        partial[t].pushBatch(Span<const int>(input.data() + begin, min(kBatchSize, last - begin)));
+    });
+  }
+  for (thread &worker : threads)
+    worker.join();
+  for (int t = 1; t < num_threads; t++)
+    partial[0].merge(partial[t]);
+  const vector<int> top_k = partial[0].sorted();
+  const auto endTime = chrono::high_resolution_clock::now();
+  const vector<PerfCounters::Reading> top_k_counters = StopCounters();
+  const long long top_k_duration = ComputeDuration(beginTime, endTime);
+
+  vector<int> partial_sortVector = input;
+  StartCounters();
+  const auto beginTime1 = chrono::high_resolution_clock::now();
+  PartialSort(partial_sortVector, k, less_than);
+  const auto endTime1 = chrono::high_resolution_clock::now();
+  const vector<PerfCounters::Reading> partial_counters = StopCounters();
+  const long long partial_duration = ComputeDuration(beginTime1, endTime1);
+
+  cout << "TopK (k = " << k << ", " << num_threads << " threads)" << endl << "Runtime: " << top_k_duration << " ns\n";
+  PrintCounterRates(top_k_counters, input.size());
+  cout << "Verified: " << equal(top_k.begin(), top_k.end(), partial_sortVector.begin()) << "\n";
+  cout << "PartialSort" << endl << "Runtime: " << partial_duration << " ns\n";
+  PrintCounterRates(partial_counters, input.size());
+  cout << "Speedup over PartialSort: " << (top_k_duration > 0 ? double(partial_duration) / top_k_duration : 0.0) << "x\n";
+}
+
+// Compares absolute values, so that -n and n are equivalent.
+struct AbsoluteLess {
+  constexpr bool operator()(int lhs, int rhs) const { return (lhs < 0 ? -lhs : lhs) < (rhs < 0 ? -rhs : rhs); }
+};
+
+template <size_t N, typename Comparator>
+constexpr array<int, N> SortedFixed(array<int, N> a, Comparator less_than) {
+  SortFixed(a, less_than);
+  return a;
+}
+
+// SortFixed runs at compile time, and keeps items that are equivalent
+// but not identical instead of duplicating one of them.
+static_assert(SortedFixed(array<int, 3>{3, 1, 2}, less<int>{})[0] == 1 &&
+              SortedFixed(array<int, 3>{3, 1, 2}, less<int>{})[2] == 3, "SortFixed sorts");
+static_assert(SortedFixed(array<int, 4>{-3, 3, 2, -2}, AbsoluteLess{})[0] +
+              SortedFixed(array<int, 4>{-3, 3, 2, -2}, AbsoluteLess{})[1] == 0 &&
+              SortedFixed(array<int, 4>{-3, 3, 2, -2}, AbsoluteLess{})[2] +
+              SortedFixed(array<int, 4>{-3, 3, 2, -2}, AbsoluteLess{})[3] == 0, "SortFixed permutes");
+
+// Splits @input into arrays of N items and sorts each, once with
+// insertionSort and once with SortFixed, and prints both runtimes.
+// Equal items can differ in sign, as 0.0 and -0.0 do, so each sorted
+// array must also keep the number of negative items of its input.
+template <size_t N, typename Comparable, typename Comparator>
+void TestSortFixed(const vector<Comparable> &input, Comparator less_than) {
+  vector<array<Comparable, N>> arrays(input.size() / N);
+  for (size_t i = 0; i < arrays.size(); i++)
+    copy(input.begin() + i * N, input.begin() + (i + 1) * N, arrays[i].begin());
+
+  vector<array<Comparable, N>> insertion_sortArrays = arrays;
+  StartCounters();
+  const auto beginTime = chrono::high_resolution_clock::now();
+  for (array<Comparable, N> &a : insertion_sortArrays)
+    insertionSort(a.begin(), a.end(), less_than);
+  const auto endTime = chrono::high_resolution_clock::now();
+  const vector<PerfCounters::Reading> insertion_counters = StopCounters();
+  const long long insertion_duration = ComputeDuration(beginTime, endTime);
+
+  StartCounters();
+  const auto beginTime1 = chrono::high_resolution_clock::now();
+  for (array<Comparable, N> &a : arrays)
+    SortFixed(a, less_than);
+  const auto endTime1 = chrono::high_resolution_clock::now();
+  const vector<PerfCounters::Reading> fixed_counters = StopCounters();
+  const long long fixed_duration = ComputeDuration(beginTime1, endTime1);
+
+  bool permuted = true;
+  for (size_t i = 0; i < arrays.size(); i++) {
+    auto negative = [](Comparable x) { return signbit(x); };
+    permuted = permuted && count_if(arrays[i].begin(), arrays[i].end(), negative) ==
+                           count_if(insertion_sortArrays[i].begin(), insertion_sortArrays[i].end(), negative);
+  }
+
+  cout << "SortFixed<" << N << "> (" << arrays.size() << " arrays)" << endl << "Runtime: " << fixed_duration << " ns\n";
+  PrintCounterRates(fixed_counters, arrays.size() * N);
+  cout << "Verified: " << (arrays == insertion_sortArrays && permuted) << "\n";
+  cout << "insertionSort" << endl << "Runtime: " << insertion_duration << " ns\n";
+  PrintCounterRates(insertion_counters, arrays.size() * N);
+  cout << "Speedup over insertionSort: " << (fixed_duration > 0 ? double(insertion_duration) / fixed_duration : 0.0) << "x\n";
+}
+
+// Sorts most of @input as a base and adds the rest as a batch, once with
+// InsertSorted and once by appending and running QuickSort on the whole
+// vector, for batch/base ratios from 0.0001 to 1.
+template <typename Comparator>
+void TestInsertSorted(const vector<int> &input, Comparator less_than) {
+  const vector<double> ratios = {0.0001, 0.001, 0.01, 0.1, 1.0};
+  for (size_t r = 0; r < ratios.size(); r++) {
+    const double ratio = ratios[r];
+    const size_t batch_size = max<size_t>(size_t(input.size() * ratio / (1 + ratio)), 1);
+    if (batch_size >= input.size())
+      continue;
+    vector<int> base(input.begin(), input.end() - batch_size);
+    const vector<int> batch(input.end() - batch_size, input.end());
+    QuickSort(base, less_than);
+
+    vector<int> quick_sortVector = base;
+    quick_sortVector.reserve(input.size());
+    StartCounters();
+    const auto beginTime = chrono::high_resolution_clock::now();
+    quick_sortVector.insert(quick_sortVector.end(), batch.begin(), batch.end());
+    QuickSort(quick_sortVector, less_than);
+    const auto endTime = chrono::high_resolution_clock::now();
+    const vector<PerfCounters::Reading> sort_counters = StopCounters();
+    const long long sort_duration = ComputeDuration(beginTime, endTime);
+
+    vector<int> insert_sortedVector = base;
+    insert_sortedVector.reserve(input.size());
+    StartCounters();
+    const auto beginTime1 = chrono::high_resolution_clock::now();
+    InsertSorted(insert_sortedVector, batch, less_than);
+    const auto endTime1 = chrono::high_resolution_clock::now();
+    const vector<PerfCounters::Reading> insert_counters = StopCounters();
+    const long long insert_duration = ComputeDuration(beginTime1, endTime1);
+
+    if (r > 0)
+      cout << endl;
+    cout << "Batch of " << batch_size << " into " << base.size() << " (ratio " << ratio << ")" << endl;
+    cout << "Append + QuickSort Runtime: " << sort_duration << " ns\n";
+    PrintCounterRates(sort_counters, quick_sortVector.size());
+    cout << "InsertSorted Runtime: " << insert_duration << " ns\n";
+    PrintCounterRates(insert_counters, insert_sortedVector.size());
+    cout << "Verified: " << (insert_sortedVector == quick_sortVector) << "\n";
+    cout << "Speedup: " << (insert_duration > 0 ? double(sort_duration) / insert_duration : 0.0) << "x\n";
+  }
+}
+
+// Writes @input to a binary file, sorts it with ExternalSort and reads the
+// result back to verify it. The memory budget is taken from the
+// SORT_MEMORY_BUDGET_MB environment variable, and defaults to a quarter of
+// the input so that several runs get merged. Temporary files go to
+// SORT_TEMP_DIR, or the current directory.
+template <typename Comparator>
+void TestExternalSort(const vector<int> &input, Comparator less_than) {
+  ExternalSortOptions options;
+  const char *budget_mb = getenv("SORT_MEMORY_BUDGET_MB");
+  options.memory_budget_bytes = budget_mb != nullptr ? size_t(atof(budget_mb) * (1 << 20)) : input.size() * sizeof(int) / 4;
+  const char *temp_dir = getenv("SORT_TEMP_DIR");
+  if (temp_dir != nullptr)
+    options.temp_directory = temp_dir;
+
+  const string input_path = options.temp_directory + "/external_sort_input.bin";
+  const string output_path = options.temp_directory + "/external_sort_output.bin";
+  ofstream input_file(input_path, ios::binary);
+  input_file.write(reinterpret_cast<const char *>(input.data()), input.size() * sizeof(int));
+  input_file.close();
+
+  ExternalSortStats stats;
+  StartCounters();
+  const bool ok = ExternalSort<int>(input_path, output_path, less_than, options, &stats);
+  const vector<PerfCounters::Reading> external_counters = StopCounters();
+  vector<int> external_sortVector(input.size());
+  ifstream output_file(output_path, ios::binary);
+  output_file.read(reinterpret_cast<char *>(external_sortVector.data()), external_sortVector.size() * sizeof(int));
+  output_file.close();
+  remove(input_path.c_str());
+  remove(output_path.c_str());
+
+  if (!ok) {
+    cout << "External sort: I/O error in " << options.temp_directory << "\n";
+    return;
+  }
+  cout << "External sort (" << options.memory_budget_bytes / 1024 << " KiB budget, " << stats.runs << " runs, "
+       << stats.merge_passes << " merge passes)" << endl;
+  cout << "Runtime: " << (long long)((stats.run_seconds + stats.merge_seconds) * 1e9) << " ns\n";
+  cout << "Run phase: " << (long long)(stats.run_seconds * 1e9) << " ns, merge phase: " << (long long)(stats.merge_seconds * 1e9) << " ns\n";
+  cout << "Throughput: " << stats.throughput() << " MB/s\n";
+  PrintCounterRates(external_counters, input.size());
+  cout << "Verified: " << (stats.records == input.size() && VerifyOrder(external_sortVector, less_than)) << "\n";
+}
+
+// Maps the binary file at @path as an array of T, sorts it in place with
+// QuickSort and writes it back with msync, printing the time of each step.
+template <typename T, typename Comparator>
+void TestMappedFile(const string &path, Comparator less_than) {
+  MappedFile file(path);
+  if (!file.isOpen()) {
+    cout << path << ": " << file.error() << endl;
+    return;
+  }
+  Span<T> items = file.span<T>();
+  if (items.size() > size_t(numeric_limits<int>::max())) {
+    cout << path << ": more than " << numeric_limits<int>::max() << " items" << endl;
+    return;
+  }
+  cout << "Sorting " << items.size() << " items of " << sizeof(T) << " bytes in " << path << endl;
+
+  // The drivers sort a Span in place, without radix sorting its integers
+  // through a buffer as large as the file.
+  StartCounters();
+  const auto beginTime = chrono::high_resolution_clock::now();
+  QuickSort(items, less_than);
+  const auto endTime = chrono::high_resolution_clock::now();
+  StopCounters();
+  const long long sort_duration = ComputeDuration(beginTime, endTime);
+  cout << "QuickSort" << endl << "Runtime: " << sort_duration << " ns\n";
+  PrintCounterRates(items.size());
+  cout << "Verified: " << VerifyOrder(items, less_than) << "\n";
+
+  const auto beginTime1 = chrono::high_resolution_clock::now();
+  const bool synced = file.sync();
+  const auto endTime1 = chrono::high_resolution_clock::now();
+  const long long sync_duration = ComputeDuration(beginTime1, endTime1);
+  if (!synced)
+    cout << path << ": " << file.error() << endl;
+  cout << "msync" << endl << "Runtime: " << sync_duration << " ns\n";
+  const long long total = sort_duration + sync_duration;
+  cout << "Throughput: " << (total > 0 ? file.size() * 1000.0 / total : 0.0) << " MB/s\n";
+}
+
+// Sorts a binary file in place; see TestMappedFile. @input_type is
+// mmap_int32, mmap_int64, mmap_float or mmap_double.
+void TestMappedFileWrapper(const string &input_type, const string &path, const string &comparison_type) {
+  const bool less_than = comparison_type == "less";
+  if (input_type == "mmap_int32")
+    less_than ? TestMappedFile<int32_t>(path, less<int32_t>{}) : TestMappedFile<int32_t>(path, greater<int32_t>{});
+  else if (input_type == "mmap_int64")
+    less_than ? TestMappedFile<int64_t>(path, less<int64_t>{}) : TestMappedFile<int64_t>(path, greater<int64_t>{});
+  else if (input_type == "mmap_float")
+    less_than ? TestMappedFile<float>(path, less<float>{}) : TestMappedFile<float>(path, greater<float>{});
+  else
+    less_than ? TestMappedFile<double>(path, less<double>{}) : TestMappedFile<double>(path, greater<double>{});
+}
+
 // Wrapper function to test different sorting algorithms. See homework's PDF for details.
 void testSortingWrapper(int argc, char **argv) {
   const string input_type = string(argv[1]);
-  const int input_size = stoi(string(argv[2]));
   const string comparison_type = string(argv[3]);
-  if (input_type != "random" && input_type != "sorted_small_to_large" && input_type != "sorted_large_to_small") {
+  if (input_type == "mmap_int32" || input_type == "mmap_int64" || input_type == "mmap_float" || input_type == "mmap_double") {
+    if (comparison_type != "less" && comparison_type != "greater") {
+      cout << "Invalid comparison type" << endl;
+      return;
+    }
+    // The second argument is the file to sort instead of a size.
+    TestMappedFileWrapper(input_type, string(argv[2]), comparison_type);
+    return;
+  }
+  const int input_size = stoi(string(argv[2]));
+  if (input_type != "random" && input_type != "sorted_small_to_large" && input_type != "sorted_large_to_small" &&
+      input_type != "few_unique") {
     cout << "Invalid input type" << endl;
     return;
   }
@@ -113,112 +766,535 @@ void testSortingWrapper(int argc, char **argv) {
   // TestTiming();
 
   cout << "Running sorting algorithms: " << input_type << " " << input_size << " numbers " << comparison_type << endl;
-  vector<int> input_vector;
 	vector<int> heap_sortVector;
 	vector<int> merge_sortVector;
 	vector<int> quick_sortVector;
 	vector<int> quick_sortVector2;
 	vector<int> quick_sortVector3;
+	vector<int> parallel_merge_sortVector;
+	vector<int> parallel_quick_sortInput;
+	vector<int> intro_sortInput;
+	const int num_threads = sortThreadCount(0);
+	const bool sorted_input = input_type == "sorted_small_to_large" || input_type == "sorted_large_to_small";
+	const int kMaxFirstPivotSortedSize = 20000;
 
   if (input_type == "random") {
-    // Generate random vector @input_vector.
+    // Generate random vectors.
 		heap_sortVector = GenerateRandomVector(input_size);
 		merge_sortVector = GenerateRandomVector(input_size);
 		quick_sortVector = GenerateRandomVector(input_size);
 		quick_sortVector2 = GenerateRandomVector(input_size);
 		quick_sortVector3 = GenerateRandomVector(input_size);
+		parallel_merge_sortVector = GenerateRandomVector(input_size);
+		parallel_quick_sortInput = GenerateRandomVector(input_size);
+		intro_sortInput = GenerateRandomVector(input_size);
+  }
+  else if (input_type == "few_unique") {
+    // Generate vectors with 8 distinct values.
+    const int kDistinct = 8;
+    heap_sortVector = GenerateFewUniqueVector(input_size, kDistinct);
+    merge_sortVector = GenerateFewUniqueVector(input_size, kDistinct);
+    quick_sortVector = GenerateFewUniqueVector(input_size, kDistinct);
+    quick_sortVector2 = GenerateFewUniqueVector(input_size, kDistinct);
+    quick_sortVector3 = GenerateFewUniqueVector(input_size, kDistinct);
+    parallel_merge_sortVector = GenerateFewUniqueVector(input_size, kDistinct);
+    parallel_quick_sortInput = GenerateFewUniqueVector(input_size, kDistinct);
+    intro_sortInput = GenerateFewUniqueVector(input_size, kDistinct);
   }
   else {
-    // Generate sorted vector @input_vector.
+    // Generate sorted vectors.
 		bool smaller_to_larger = (input_type == "sorted_small_to_large" ? true : false);
     heap_sortVector = GenerateSortedVector(input_size, smaller_to_larger);
     merge_sortVector = GenerateSortedVector(input_size, smaller_to_larger);
     quick_sortVector = GenerateSortedVector(input_size, smaller_to_larger);
     quick_sortVector2 = GenerateSortedVector(input_size, smaller_to_larger);
     quick_sortVector3 = GenerateSortedVector(input_size, smaller_to_larger);
+    parallel_merge_sortVector = GenerateSortedVector(input_size, smaller_to_larger);
+    parallel_quick_sortInput = GenerateSortedVector(input_size, smaller_to_larger);
+    intro_sortInput = GenerateSortedVector(input_size, smaller_to_larger);
   }
 
   if (comparison_type == "less") {
+    StartCounters();
     const auto beginTime = chrono::high_resolution_clock::now();
-    HeapSort(input_vector, less<int>{});
+    HeapSort(heap_sortVector, less<int>{});
     const auto endTime = chrono::high_resolution_clock::now();
+    StopCounters();
     cout << "Heapsort" << endl << "Runtime: " << ComputeDuration(beginTime, endTime) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << "\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(heap_sortVector, less<int>{}) << "\n";
 
+    StartCounters();
     const auto beginTime1 = chrono::high_resolution_clock::now();
-    MergeSort(input_vector, less<int>{});
+    MergeSort(merge_sortVector, less<int>{});
     const auto endTime1 = chrono::high_resolution_clock::now();
+    StopCounters();
     cout << endl;
     cout << "MergeSort" << endl << "Runtime: " << ComputeDuration(beginTime1, endTime1) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << "\n\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(merge_sortVector, less<int>{}) << "\n\n";
 
+    StartCounters();
+    const auto beginTimeP = chrono::high_resolution_clock::now();
+    ParallelMergeSort(parallel_merge_sortVector, less<int>{}, num_threads);
+    const auto endTimeP = chrono::high_resolution_clock::now();
+    StopCounters();
+    cout << "Parallel MergeSort (" << num_threads << " threads)" << endl << "Runtime: " << ComputeDuration(beginTimeP, endTimeP) << " ns\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(parallel_merge_sortVector, less<int>{}) << "\n\n";
+
+    StartCounters();
     const auto beginTime2 = chrono::high_resolution_clock::now();
-    QuickSort(input_vector, less<int>{});
+    QuickSort(quick_sortVector, less<int>{});
     const auto endTime2 = chrono::high_resolution_clock::now();
+    StopCounters();
     cout << "QuickSort" << endl << "Runtime: " << ComputeDuration(beginTime2, endTime2) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << "\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(quick_sortVector, less<int>{}) << "\n";
 
+    cout << endl;
+    TestParallelQuickSort(parallel_quick_sortInput, less<int>{}, num_threads);
     cout << "\nTesting Quicksort Pivot Implementations" << endl;
     cout << endl;
 
+    vector<int> median_of_threeVector = intro_sortInput;
+    StartCounters();
     const auto beginTime3 = chrono::high_resolution_clock::now();
+    quicksort(median_of_threeVector, less<int>{});
     const auto endTime3 = chrono::high_resolution_clock::now();
+    StopCounters();
     cout << "Median of Three" << endl << "Runtime: " << ComputeDuration(beginTime3, endTime3) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << "\n\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(median_of_threeVector, less<int>{}) << "\n\n";
 
+    StartCounters();
     const auto beginTime4 = chrono::high_resolution_clock::now();
-    QuickSort2(input_vector, less<int>{});
+    QuickSort2(quick_sortVector2, less<int>{});
     const auto endTime4 = chrono::high_resolution_clock::now();
+    StopCounters();
     cout << "Middle" << endl << "Runtime: " << ComputeDuration(beginTime4, endTime4) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << "\n\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(quick_sortVector2, less<int>{}) << "\n\n";
+
+    // The first item is the worst pivot on sorted input: quadratic time
+    // and linear recursion depth.
+    if (sorted_input && input_size > kMaxFirstPivotSortedSize) {
+      cout << "First" << endl << "Skipped: sorted input of more than " << kMaxFirstPivotSortedSize << " items\n";
+    }
+    else {
+      StartCounters();
+      const auto beginTime5 = chrono::high_resolution_clock::now();
+      QuickSort3(quick_sortVector3, less<int>{});
+      const auto endTime5 = chrono::high_resolution_clock::now();
+      StopCounters();
+      cout << "First" << endl << "Runtime: " << ComputeDuration(beginTime5, endTime5) << " ns\n";
+      PrintCounterRates(input_size);
+      cout << "Verified: " << VerifyOrder(quick_sortVector3, less<int>{}) << "\n";
+    }
+
+    cout << "\nTesting d-ary HeapSort" << endl;
+    cout << endl;
+
+    TestSortingAlgorithm("Binary heap", intro_sortInput, [](vector<int> &a) { heapsort(a, less<int>{}); }, less<int>{});
+    cout << endl;
+    TestSortingAlgorithm("4-ary heap", intro_sortInput, [](vector<int> &a) { dAryHeapsort<4>(a, less<int>{}); }, less<int>{});
+    cout << endl;
+    TestSortingAlgorithm("8-ary heap", intro_sortInput, [](vector<int> &a) { dAryHeapsort<8>(a, less<int>{}); }, less<int>{});
+
+    cout << "\nTesting Bottom-Up MergeSort" << endl;
+    cout << endl;
+
+    const long long top_down_mergeRuntime = TestSortingAlgorithm("Top-down MergeSort", intro_sortInput, [](vector<int> &a) { mergeSort(a, less<int>{}); }, less<int>{});
+    cout << endl;
+    const long long bottom_up_mergeRuntime = TestSortingAlgorithm("Bottom-up MergeSort", intro_sortInput, [](vector<int> &a) { mergeSortBottomUp(a, less<int>{}); }, less<int>{});
+    cout << "Speedup over top-down: " << (bottom_up_mergeRuntime > 0 ? double(top_down_mergeRuntime) / bottom_up_mergeRuntime : 0.0) << "x\n";
+    cout << endl;
+    const long long tim_sortRuntime = TestSortingAlgorithm("TimSort", intro_sortInput, [](vector<int> &a) { TimSort(a, less<int>{}); }, less<int>{});
+    cout << "Speedup over bottom-up: " << (tim_sortRuntime > 0 ? double(bottom_up_mergeRuntime) / tim_sortRuntime : 0.0) << "x\n";
+
+    cout << "\nTesting Introsort Pivot Implementations" << endl;
+    cout << endl;
+
+    TestSortingAlgorithm("Median of Three", intro_sortInput, [](vector<int> &a) { IntroSort(a, less<int>{}); }, less<int>{});
+    cout << endl;
+    TestSortingAlgorithm("Middle", intro_sortInput, [](vector<int> &a) { IntroSort2(a, less<int>{}); }, less<int>{});
+    cout << endl;
+    TestSortingAlgorithm("First", intro_sortInput, [](vector<int> &a) { IntroSort3(a, less<int>{}); }, less<int>{});
+
+    cout << "\nTesting Pattern-Defeating QuickSort" << endl;
+    cout << endl;
+
+    const long long quick_sortRuntime = TestSortingAlgorithm("QuickSort (comparisons only)", intro_sortInput, [](vector<int> &a) { quicksort(a, less<int>{}); }, less<int>{});
+    cout << endl;
+    const long long pdq_sortRuntime = TestSortingAlgorithm("PdqSort", intro_sortInput, [](vector<int> &a) { PdqSort(a, less<int>{}); }, less<int>{});
+    cout << "Speedup over QuickSort: " << (pdq_sortRuntime > 0 ? double(quick_sortRuntime) / pdq_sortRuntime : 0.0) << "x\n";
+
+    cout << "\nTesting Three-Way QuickSort" << endl;
+    cout << endl;
+
+    const long long quick_sort3WayRuntime = TestSortingAlgorithm("QuickSort3Way", intro_sortInput, [](vector<int> &a) { QuickSort3Way(a, less<int>{}); }, less<int>{});
+    cout << "Speedup over QuickSort: " << (quick_sort3WayRuntime > 0 ? double(quick_sortRuntime) / quick_sort3WayRuntime : 0.0) << "x\n";
+    cout << endl;
+    const vector<string> string_3WayInput = GenerateStringVector(intro_sortInput);
+    const long long quick_sortStringRuntime = TestSortingAlgorithm("QuickSort (strings)", string_3WayInput, [](vector<string> &a) { quicksort(a, less<string>{}); }, less<string>{});
+    cout << endl;
+    const long long quick_sort3WayStringRuntime = TestSortingAlgorithm("QuickSort3Way (strings)", string_3WayInput, [](vector<string> &a) { QuickSort3Way(a, less<string>{}); }, less<string>{});
+    cout << "Speedup over QuickSort: " << (quick_sort3WayStringRuntime > 0 ? double(quick_sortStringRuntime) / quick_sort3WayStringRuntime : 0.0) << "x\n";
 
-    const auto beginTime5 = chrono::high_resolution_clock::now();
-    QuickSort3(input_vector, less<int>{});
-    const auto endTime5 = chrono::high_resolution_clock::now();
-    cout << "First" << endl << "Runtime: " << ComputeDuration(beginTime5, endTime5) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << "\n";
+    cout << "\nTesting SIMD Partition" << endl;
+    cout << endl;
+
+    TestPartitionPass(intro_sortInput, less<int>{});
+
+    cout << "\nTesting Sorting Network Leaves" << endl;
+    cout << endl;
+
+    TestNetworkLeaves<less>(intro_sortInput);
+
+    cout << "\nTesting LSD RadixSort" << endl;
+    cout << endl;
+
+    TestSortingAlgorithm("RadixSort", intro_sortInput, [](vector<int> &a) { RadixSort(a, less<int>{}); }, less<int>{});
+
+    cout << "\nTesting External Sort" << endl;
+    cout << endl;
+
+    TestExternalSort(intro_sortInput, less<int>{});
+
+    cout << "\nTesting ArgSort" << endl;
+    cout << endl;
+
+    TestArgSort(intro_sortInput, less<int>{});
+
+    cout << "\nTesting Stable Multi-Key MergeSort" << endl;
+    cout << endl;
+
+    TestProjectionSort(intro_sortInput, less<int>{});
+
+    cout << "\nTesting Selection" << endl;
+    cout << endl;
+
+    TestSelection(intro_sortInput, less<int>{});
+
+    cout << "\nTesting Streaming TopK" << endl;
+    cout << endl;
+
+    TestTopK(intro_sortInput, less<int>{}, num_threads);
+
+    cout << "\nTesting Incremental Insertion" << endl;
+    cout << endl;
+
+    TestInsertSorted(intro_sortInput, less<int>{});
+
+    cout << "\nTesting Adaptive Sort" << endl;
+    cout << endl;
+
+    vector<int> adaptive_sortVector = intro_sortInput;
+    Sort(adaptive_sortVector, less<int>{}, &cout);
+    TestSortingAlgorithm("Sort", intro_sortInput, [](vector<int> &a) { Sort(a, less<int>{}); }, less<int>{});
+    cout << endl;
+    vector<string> adaptive_sortStrings = GenerateStringVector(intro_sortInput);
+    Sort(adaptive_sortStrings, less<string>{}, &cout);
+    TestSortingAlgorithm("Sort (strings)", GenerateStringVector(intro_sortInput), [](vector<string> &a) { Sort(a, less<string>{}); }, less<string>{});
+
+    cout << "\nTesting Fixed-Size Sorting Networks" << endl;
+    cout << endl;
+
+    TestSortFixed<3>(intro_sortInput, less<int>{});
+    cout << endl;
+    TestSortFixed<8>(intro_sortInput, less<int>{});
+    cout << endl;
+    TestSortFixed<13>(intro_sortInput, less<int>{});
+    cout << endl;
+    TestSortFixed<16>(intro_sortInput, less<int>{});
+    cout << endl;
+    TestSortFixed<21>(intro_sortInput, less<int>{});
+    cout << endl;
+    TestSortFixed<27>(intro_sortInput, less<int>{});
+    cout << endl;
+    TestSortFixed<32>(intro_sortInput, less<int>{});
+    cout << endl;
+    TestSortFixed<5>(vector<double>(intro_sortInput.begin(), intro_sortInput.end()), less<double>{});
+    cout << endl;
+    TestSortFixed<19>(vector<double>(intro_sortInput.begin(), intro_sortInput.end()), less<double>{});
+    cout << endl;
+    TestSortFixed<29>(vector<double>(intro_sortInput.begin(), intro_sortInput.end()), less<double>{});
+    cout << endl;
+    TestSortFixed<16>(GenerateSignedZeroVector(intro_sortInput), less<double>{});
+    cout << endl;
+    TestSortFixed<27>(GenerateSignedZeroVector(intro_sortInput), less<double>{});
+
+    cout << "\nTesting Operation Counts" << endl;
+    cout << endl;
+
+    TestOperationCounts("HeapSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<less<CountedInt>> c) { HeapSort(a, c); }, less<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("MergeSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<less<CountedInt>> c) { MergeSort(a, c); }, less<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("TimSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<less<CountedInt>> c) { TimSort(a, c); }, less<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("QuickSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<less<CountedInt>> c) { QuickSort(a, c); }, less<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("IntroSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<less<CountedInt>> c) { IntroSort(a, c); }, less<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("PdqSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<less<CountedInt>> c) { PdqSort(a, c); }, less<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("QuickSort3Way", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<less<CountedInt>> c) { QuickSort3Way(a, c); }, less<CountedInt>{});
+
+    // SORT always orders with operator<, so it is only run here.
+    cout << "\nTesting Arena-Backed SORT" << endl;
+    cout << endl;
+
+    TestSortingAlgorithm("SORT", intro_sortInput, [](vector<int> &a) { SORT(a); }, less<int>{});
+
+    cout << "\nTesting String Sorts" << endl;
+    cout << endl;
+
+    const vector<string> string_sortInput = GenerateStringVector(intro_sortInput);
+    TestSortingAlgorithm("QuickSort", string_sortInput, [](vector<string> &a) { QuickSort(a, less<string>{}); }, less<string>{});
+    cout << endl;
+    TestSortingAlgorithm("AmericanFlagSort", string_sortInput, [](vector<string> &a) { AmericanFlagSort(a, less<string>{}); }, less<string>{});
+    cout << endl;
+    TestSortingAlgorithm("MultikeyQuickSort", string_sortInput, [](vector<string> &a) { MultikeyQuickSort(a, less<string>{}); }, less<string>{});
   }
   else if (comparison_type == "greater") {
+    StartCounters();
     const auto beginTime = chrono::high_resolution_clock::now();
-    HeapSort(input_vector, greater<int>{});
+    HeapSort(heap_sortVector, greater<int>{});
     const auto endTime = chrono::high_resolution_clock::now();
+    StopCounters();
     cout << "Heapsort" << endl << "Runtime: " << ComputeDuration(beginTime, endTime) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << "\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(heap_sortVector, greater<int>{}) << "\n";
 
+    StartCounters();
     const auto beginTime1 = chrono::high_resolution_clock::now();
-    MergeSort(input_vector, greater<int>{});
+    MergeSort(merge_sortVector, greater<int>{});
     const auto endTime1 = chrono::high_resolution_clock::now();
+    StopCounters();
     cout << endl;
     cout << "MergeSort" << "Runtime: " << ComputeDuration(beginTime1, endTime1) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << "\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(merge_sortVector, greater<int>{}) << "\n";
 
+    StartCounters();
+    const auto beginTimeP = chrono::high_resolution_clock::now();
+    ParallelMergeSort(parallel_merge_sortVector, greater<int>{}, num_threads);
+    const auto endTimeP = chrono::high_resolution_clock::now();
+    StopCounters();
+    cout << "Parallel MergeSort (" << num_threads << " threads)" << endl << "Runtime: " << ComputeDuration(beginTimeP, endTimeP) << " ns\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(parallel_merge_sortVector, greater<int>{}) << "\n";
+
+    StartCounters();
     const auto beginTime2 = chrono::high_resolution_clock::now();
-    QuickSort(input_vector, greater<int>{});
+    QuickSort(quick_sortVector, greater<int>{});
     const auto endTime2 = chrono::high_resolution_clock::now();
+    StopCounters();
     cout << endl;
     cout << "QuickSort" << endl << "Runtime: " << ComputeDuration(beginTime2, endTime2) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << "\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(quick_sortVector, greater<int>{}) << "\n";
 
+    cout << endl;
+    TestParallelQuickSort(parallel_quick_sortInput, greater<int>{}, num_threads);
     cout << "\nTesting Quicksort Pivot Implementations" << endl;
 
     cout << endl;
 
+    vector<int> median_of_threeVector = intro_sortInput;
+    StartCounters();
     const auto beginTime3 = chrono::high_resolution_clock::now();
+    quicksort(median_of_threeVector, greater<int>{});
     const auto endTime3 = chrono::high_resolution_clock::now();
+    StopCounters();
     cout << "Median of Three" << endl << "Runtime: " << ComputeDuration(beginTime3, endTime3) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << "\n\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(median_of_threeVector, greater<int>{}) << "\n\n";
 
+    StartCounters();
     const auto beginTime4 = chrono::high_resolution_clock::now();
-    QuickSort2(input_vector, greater<int>{});
+    QuickSort2(quick_sortVector2, greater<int>{});
     const auto endTime4 = chrono::high_resolution_clock::now();
+    StopCounters();
     cout << "Middle" << endl << "Runtime: " << ComputeDuration(beginTime4, endTime4) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << "\n\n";
+    PrintCounterRates(input_size);
+    cout << "Verified: " << VerifyOrder(quick_sortVector2, greater<int>{}) << "\n\n";
+
+    // The first item is the worst pivot on sorted input: quadratic time
+    // and linear recursion depth.
+    if (sorted_input && input_size > kMaxFirstPivotSortedSize) {
+      cout << "First" << endl << "Skipped: sorted input of more than " << kMaxFirstPivotSortedSize << " items\n";
+    }
+    else {
+      StartCounters();
+      const auto beginTime5 = chrono::high_resolution_clock::now();
+      QuickSort3(quick_sortVector3, greater<int>{});
+      const auto endTime5 = chrono::high_resolution_clock::now();
+      StopCounters();
+      cout << "First" << endl << "Runtime: " << ComputeDuration(beginTime5, endTime5) << " ns\n";
+      PrintCounterRates(input_size);
+      cout << "Verified: " << VerifyOrder(quick_sortVector3, greater<int>{}) << "\n";
+    }
+
+    cout << "\nTesting d-ary HeapSort" << endl;
+    cout << endl;
+
+    TestSortingAlgorithm("Binary heap", intro_sortInput, [](vector<int> &a) { heapsort(a, greater<int>{}); }, greater<int>{});
+    cout << endl;
+    TestSortingAlgorithm("4-ary heap", intro_sortInput, [](vector<int> &a) { dAryHeapsort<4>(a, greater<int>{}); }, greater<int>{});
+    cout << endl;
+    TestSortingAlgorithm("8-ary heap", intro_sortInput, [](vector<int> &a) { dAryHeapsort<8>(a, greater<int>{}); }, greater<int>{});
+
+    cout << "\nTesting Bottom-Up MergeSort" << endl;
+    cout << endl;
+
+    const long long top_down_mergeRuntime = TestSortingAlgorithm("Top-down MergeSort", intro_sortInput, [](vector<int> &a) { mergeSort(a, greater<int>{}); }, greater<int>{});
+    cout << endl;
+    const long long bottom_up_mergeRuntime = TestSortingAlgorithm("Bottom-up MergeSort", intro_sortInput, [](vector<int> &a) { mergeSortBottomUp(a, greater<int>{}); }, greater<int>{});
+    cout << "Speedup over top-down: " << (bottom_up_mergeRuntime > 0 ? double(top_down_mergeRuntime) / bottom_up_mergeRuntime : 0.0) << "x\n";
+    cout << endl;
+    const long long tim_sortRuntime = TestSortingAlgorithm("TimSort", intro_sortInput, [](vector<int> &a) { TimSort(a, greater<int>{}); }, greater<int>{});
+    cout << "Speedup over bottom-up: " << (tim_sortRuntime > 0 ? double(bottom_up_mergeRuntime) / tim_sortRuntime : 0.0) << "x\n";
+
+    cout << "\nTesting Introsort Pivot Implementations" << endl;
+    cout << endl;
+
+    TestSortingAlgorithm("Median of Three", intro_sortInput, [](vector<int> &a) { IntroSort(a, greater<int>{}); }, greater<int>{});
+    cout << endl;
+    TestSortingAlgorithm("Middle", intro_sortInput, [](vector<int> &a) { IntroSort2(a, greater<int>{}); }, greater<int>{});
+    cout << endl;
+    TestSortingAlgorithm("First", intro_sortInput, [](vector<int> &a) { IntroSort3(a, greater<int>{}); }, greater<int>{});
+
+    cout << "\nTesting Pattern-Defeating QuickSort" << endl;
+    cout << endl;
+
+    const long long quick_sortRuntime = TestSortingAlgorithm("QuickSort (comparisons only)", intro_sortInput, [](vector<int> &a) { quicksort(a, greater<int>{}); }, greater<int>{});
+    cout << endl;
+    const long long pdq_sortRuntime = TestSortingAlgorithm("PdqSort", intro_sortInput, [](vector<int> &a) { PdqSort(a, greater<int>{}); }, greater<int>{});
+    cout << "Speedup over QuickSort: " << (pdq_sortRuntime > 0 ? double(quick_sortRuntime) / pdq_sortRuntime : 0.0) << "x\n";
+
+    cout << "\nTesting Three-Way QuickSort" << endl;
+    cout << endl;
+
+    const long long quick_sort3WayRuntime = TestSortingAlgorithm("QuickSort3Way", intro_sortInput, [](vector<int> &a) { QuickSort3Way(a, greater<int>{}); }, greater<int>{});
+    cout << "Speedup over QuickSort: " << (quick_sort3WayRuntime > 0 ? double(quick_sortRuntime) / quick_sort3WayRuntime : 0.0) << "x\n";
+    cout << endl;
+    const vector<string> string_3WayInput = GenerateStringVector(intro_sortInput);
+    const long long quick_sortStringRuntime = TestSortingAlgorithm("QuickSort (strings)", string_3WayInput, [](vector<string> &a) { quicksort(a, greater<string>{}); }, greater<string>{});
+    cout << endl;
+    const long long quick_sort3WayStringRuntime = TestSortingAlgorithm("QuickSort3Way (strings)", string_3WayInput, [](vector<string> &a) { QuickSort3Way(a, greater<string>{}); }, greater<string>{});
+    cout << "Speedup over QuickSort: " << (quick_sort3WayStringRuntime > 0 ? double(quick_sortStringRuntime) / quick_sort3WayStringRuntime : 0.0) << "x\n";
+
+    cout << "\nTesting SIMD Partition" << endl;
+    cout << endl;
+
+    TestPartitionPass(intro_sortInput, greater<int>{});
+
+    cout << "\nTesting Sorting Network Leaves" << endl;
+    cout << endl;
+
+    TestNetworkLeaves<greater>(intro_sortInput);
+
+    cout << "\nTesting LSD RadixSort" << endl;
+    cout << endl;
+
+    TestSortingAlgorithm("RadixSort", intro_sortInput, [](vector<int> &a) { RadixSort(a, greater<int>{}); }, greater<int>{});
+
+    cout << "\nTesting External Sort" << endl;
+    cout << endl;
+
+    TestExternalSort(intro_sortInput, greater<int>{});
+
+    cout << "\nTesting ArgSort" << endl;
+    cout << endl;
+
+    TestArgSort(intro_sortInput, greater<int>{});
+
+    cout << "\nTesting Stable Multi-Key MergeSort" << endl;
+    cout << endl;
+
+    TestProjectionSort(intro_sortInput, greater<int>{});
+
+    cout << "\nTesting Selection" << endl;
+    cout << endl;
+
+    TestSelection(intro_sortInput, greater<int>{});
 
-    const auto beginTime5 = chrono::high_resolution_clock::now();
-    QuickSort3(input_vector, greater<int>{});
-    const auto endTime5 = chrono::high_resolution_clock::now();
-    cout << "First" << endl << "Runtime: " << ComputeDuration(beginTime5, endTime5) << " ns\n";
-    cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << "\n";
+    cout << "\nTesting Streaming TopK" << endl;
+    cout << endl;
+
+    TestTopK(intro_sortInput, greater<int>{}, num_threads);
+
+    cout << "\nTesting Incremental Insertion" << endl;
+    cout << endl;
+
+    TestInsertSorted(intro_sortInput, greater<int>{});
+
+    cout << "\nTesting Adaptive Sort" << endl;
+    cout << endl;
+
+    vector<int> adaptive_sortVector = intro_sortInput;
+    Sort(adaptive_sortVector, greater<int>{}, &cout);
+    TestSortingAlgorithm("Sort", intro_sortInput, [](vector<int> &a) { Sort(a, greater<int>{}); }, greater<int>{});
+    cout << endl;
+    vector<string> adaptive_sortStrings = GenerateStringVector(intro_sortInput);
+    Sort(adaptive_sortStrings, greater<string>{}, &cout);
+    TestSortingAlgorithm("Sort (strings)", GenerateStringVector(intro_sortInput), [](vector<string> &a) { Sort(a, greater<string>{}); }, greater<string>{});
+
+    cout << "\nTesting Fixed-Size Sorting Networks" << endl;
+    cout << endl;
+
+    TestSortFixed<3>(intro_sortInput, greater<int>{});
+    cout << endl;
+    TestSortFixed<8>(intro_sortInput, greater<int>{});
+    cout << endl;
+    TestSortFixed<13>(intro_sortInput, greater<int>{});
+    cout << endl;
+    TestSortFixed<16>(intro_sortInput, greater<int>{});
+    cout << endl;
+    TestSortFixed<21>(intro_sortInput, greater<int>{});
+    cout << endl;
+    TestSortFixed<27>(intro_sortInput, greater<int>{});
+    cout << endl;
+    TestSortFixed<32>(intro_sortInput, greater<int>{});
+    cout << endl;
+    TestSortFixed<5>(vector<double>(intro_sortInput.begin(), intro_sortInput.end()), greater<double>{});
+    cout << endl;
+    TestSortFixed<19>(vector<double>(intro_sortInput.begin(), intro_sortInput.end()), greater<double>{});
+    cout << endl;
+    TestSortFixed<29>(vector<double>(intro_sortInput.begin(), intro_sortInput.end()), greater<double>{});
+    cout << endl;
+    TestSortFixed<16>(GenerateSignedZeroVector(intro_sortInput), greater<double>{});
+    cout << endl;
+    TestSortFixed<27>(GenerateSignedZeroVector(intro_sortInput), greater<double>{});
+
+    cout << "\nTesting Operation Counts" << endl;
+    cout << endl;
+
+    TestOperationCounts("HeapSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<greater<CountedInt>> c) { HeapSort(a, c); }, greater<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("MergeSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<greater<CountedInt>> c) { MergeSort(a, c); }, greater<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("TimSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<greater<CountedInt>> c) { TimSort(a, c); }, greater<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("QuickSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<greater<CountedInt>> c) { QuickSort(a, c); }, greater<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("IntroSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<greater<CountedInt>> c) { IntroSort(a, c); }, greater<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("PdqSort", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<greater<CountedInt>> c) { PdqSort(a, c); }, greater<CountedInt>{});
+    cout << endl;
+    TestOperationCounts("QuickSort3Way", intro_sortInput, [](vector<CountedInt> &a, DriverComparator<greater<CountedInt>> c) { QuickSort3Way(a, c); }, greater<CountedInt>{});
+
+    cout << "\nTesting String Sorts" << endl;
+    cout << endl;
+
+    const vector<string> string_sortInput = GenerateStringVector(intro_sortInput);
+    TestSortingAlgorithm("QuickSort", string_sortInput, [](vector<string> &a) { QuickSort(a, greater<string>{}); }, greater<string>{});
+    cout << endl;
+    TestSortingAlgorithm("AmericanFlagSort", string_sortInput, [](vector<string> &a) { AmericanFlagSort(a, greater<string>{}); }, greater<string>{});
+    cout << endl;
+    TestSortingAlgorithm("MultikeyQuickSort", string_sortInput, [](vector<string> &a) { MultikeyQuickSort(a, greater<string>{}); }, greater<string>{});
   }
 }
 